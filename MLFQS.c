@@ -1,13 +1,32 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
 #include "prioque.h"
 #include "process.h"
+#include "ingest.h"
+#include "event.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "metrics.h"
+#include "service.h"
+#include "multicpu.h"
+#include "iowait.h"
+#include "deadline.h"
+#include "mlfq.h"
+
+#define METRICS_INTERVAL 1024 // ticks between two publishes of the live metrics
+#define SERVICE_POLL_TICKS 64 // ticks between two polls for submissions in service mode
+#define DEFAULT_LOOKAHEAD 100 // ticks between two synchronizations of the CPUs in multi-CPU mode
 
 ////////////////////////GLOBAL VARIABLES/////////////////////
 
 // Queues
-Queue ArrivalQueue, HighQueue, MediumQueue, LowQueue, IOQueue;
+Queue ArrivalQueue, HighQueue, MediumQueue, LowQueue;
+IOWaitSet IOQueue; // processes blocked for IO, in FIFO order
+DeadlineQueue RealTimeQueue; // ready real-time processes, earliest deadline first
 
 // Special Processes
 Process IdleProcess;    // the <<null>> process
@@ -19,57 +38,259 @@ Process higherPriority; // the highest priority process removed from the readyQu
 int quantum = 0;     // CPU time given to a process with corresponding priority
 int result = FINISH; // the result of an execution, can be DO_IO, NOT_FINISH, FINISH
 int CPUclock = 0;    // counter to model the clock of the system
-char report[255];    // String for reporting
+int pipelined = FALSE; // parse, simulate and write events on three threads
+FILE *report;        // per-process CPU usage lines, spooled to a temporary file so memory stays flat
+const char *servicePath = NULL; // service mode: processes are submitted over this Unix domain socket
+int memoryReport = FALSE; // report the memory held by the queues in the final report
+
+// Priority boost (anti-starvation)
+int boostInterval = 0;           // every boostInterval ticks all processes return to level 1, 0 disables boosting
+unsigned int boostEpoch = 0;     // incremented on every boost, processes stamped with an older epoch are boosted lazily
+int reportStarvation = FALSE;    // report ready-queue waiting times in the final report
+unsigned long boostedProcesses = 0; // number of processes moved back to level 1 by a boost
+unsigned long dispatches = 0;       // number of times a process was dispatched from a level queue
+unsigned long totalReadyWait = 0;   // total ticks processes spent waiting in the level queues
+unsigned int maxReadyWait = 0;      // longest time a process waited in the level queues
+unsigned int maxReadyWaitPID = 0;   // PID of the process that waited maxReadyWait ticks
+
+// Live metrics (-m), read by mlfqs_stat while the simulation runs
+LiveMetrics *metrics = NULL;  // shared memory segment, NULL if not published
+const char *metricsName;      // name of the shared memory object
+unsigned long promotions = 0; // number of times a process moved up a level
+unsigned long demotions = 0;  // number of times a process moved down a level
+unsigned long eventsWritten = 0; // number of report lines written
+
+// Real-time class, scheduled earliest deadline first above level 1
+double realTimeUtilization = 0;     // CPU share reserved by the admitted real-time processes
+unsigned long realTimeAdmitted = 0; // number of processes admitted to the real-time class
+unsigned long realTimeRejected = 0; // number of processes with a deadline run as ordinary processes instead
+unsigned long realTimeBursts = 0;   // number of CPU bursts real-time processes completed
+unsigned long deadlineMisses = 0;   // number of them completed after their deadline
+unsigned long worstLateness = 0;    // ticks the latest of them missed its deadline by
+unsigned int worstLatenessPID = 0;  // PID of that process
+
+// Context switch cost (-c, -W), dispatching a process is free unless one of them is given
+unsigned int switchCost = 0;    // ticks the CPU spends switching to a process other than the last one dispatched
+unsigned int warmupHorizon = 0; // ticks off the CPU after which a process finds the cache cold, 0 disables warmup
+unsigned long switchTicks = 0;  // switching ticks left before the executing process runs
+unsigned long warmupTicks = 0;  // warmup ticks left after them
+unsigned long switchLost = 0;   // ticks the CPU spent switching
+unsigned long warmupLost = 0;   // ticks the CPU spent reloading working sets
+unsigned long switches = 0;     // dispatches of a process other than the last one dispatched
+int dispatchedBefore = FALSE;   // has any process been dispatched yet, the CPU starts with no context to replace
+unsigned int lastDispatchedPID; // PID of the last process dispatched, its context is still on the CPU
 
 //////////////////////FUNCTIONS/////////////////////////////
 
 void init_all_queues()
 {
-    init_queue(&ArrivalQueue, sizeof(Process), FALSE, process_compare, FALSE);
+    init_queue(&ArrivalQueue, sizeof(Process), TRUE, process_compare, FALSE); // PIDs are made unique while reading the trace
     init_queue(&HighQueue, sizeof(Process), FALSE, process_compare, FALSE);
     init_queue(&MediumQueue, sizeof(Process), FALSE, process_compare, FALSE);
     init_queue(&LowQueue, sizeof(Process), FALSE, process_compare, FALSE);
-    init_queue(&IOQueue, sizeof(Process), FALSE, process_compare, TRUE);
+    register_queue(&ArrivalQueue, "ArrivalQueue");
+    register_queue(&HighQueue, "HighQueue");
+    register_queue(&MediumQueue, "MediumQueue");
+    register_queue(&LowQueue, "LowQueue");
+    init_iowait_set(&IOQueue);
+    init_deadline_queue(&RealTimeQueue);
 }
 
-void read_process_descriptions(void)
+void destroy_all_queues()
+{
+    destroy_queue(&ArrivalQueue);
+    destroy_queue(&HighQueue);
+    destroy_queue(&MediumQueue);
+    destroy_queue(&LowQueue);
+    destroy_iowait_set(&IOQueue);
+    destroy_deadline_queue(&RealTimeQueue);
+}
+
+// Turns the processes grouped in 'table' into Processes with interned programs and adds them to the ArrivalQueue
+void queue_ingested_processes(IngestTable *table)
 {
-    Process p;
-    ProcessBehavior b;
-    int pid = 0, first = 1;
-    unsigned long arrival;
-
-    init_process(&p);
-    arrival = 0;
-    while (scanf("%lu", &arrival) != EOF)
+    Process *arrivals;
+    unsigned long i;
+
+    arrivals = malloc(table->count * sizeof(Process) + 1);
+    if (arrivals == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function queue_ingested_processes()\n");
+        exit(1);
+    }
+    for (i = 0; i < table->count; i++)
     {
-        scanf("%d %lu %lu %d", &pid, &b.CPUBurst, &b.IOBurst, &b.repeat);
+        init_process(&arrivals[i]);
+        arrivals[i].PID = table->processes[i].PID;
+        arrivals[i].arrival_time = table->processes[i].arrival_time;
+        arrivals[i].program = intern_behavior_program(ingested_behaviors(&(table->processes[i])), table->processes[i].count);
+        arrivals[i].relativeDeadline = table->processes[i].deadline;
+        arrivals[i].period = table->processes[i].period;
+        arrivals[i].workingSet = table->processes[i].workingSet;
+    }
 
-        if (!first && p.PID != pid)
-        {
-            add_to_queue(&ArrivalQueue, &p, p.arrival_time);
-            init_process(&p);
-        }
-        p.PID = pid;
-        p.arrival_time = arrival;
-        first = 0;
-        add_to_queue(&p.Behaviors, &b, 1);
+    build_arrival_queue(&ArrivalQueue, arrivals, table->count);
+    free(arrivals);
+}
+
+/* Reads the trace from stdin. Behavior lines are grouped into processes by PID, so the lines
+   of a process do not need to be contiguous: its behaviors run in the order their lines appear
+   and its arrival time is taken from its last line.
+*/
+void read_process_descriptions(void)
+{
+    IngestTable table;
+    TraceRecord r;
+    PROFILE_SCOPE(PHASE_LOAD);
+
+    init_ingest_table(&table);
+    while (read_trace_record(stdin, &r))
+        ingest_record(&table, &r);
+
+    queue_ingested_processes(&table);
+    destroy_ingest_table(&table);
+}
+
+/* Pipelined mode: moves the trace records the reader thread parsed for processes arriving by
+   now into the ArrivalQueue. The trace is ordered by arrival, so every line of those processes
+   has been read once a record arriving later (or the end of the trace) shows up.
+*/
+void read_pipelined_arrivals(void)
+{
+    IngestTable table;
+    const TraceRecord *r;
+    PROFILE_SCOPE(PHASE_LOAD);
+
+    init_ingest_table(&table);
+    while ((r = peek_trace_record()) != NULL && r->arrival <= (unsigned int)CPUclock)
+    {
+        ingest_record(&table, r);
+        consume_trace_record();
     }
-    add_to_queue(&ArrivalQueue, &p, p.arrival_time);
+
+    if (table.count > 0)
+        queue_ingested_processes(&table);
+    destroy_ingest_table(&table);
+}
+
+// Reports a scheduling event of process 'p', through the writer thread in pipelined mode
+void emit_event(int type, const Process *p)
+{
+    SchedulerEvent e;
+
+    if (type < EVENT_IO_DONE)
+        eventsWritten++;
+    else if (!timeline_open())
+        return;
+
+    e.type = type;
+    e.PID = p->PID;
+    e.level = p->priority;
+    e.time = CPUclock;
+    e.ticks = (type == EVENT_DEADLINE_MISS) ? CPUclock - p->deadline : p->CPUTime;
+    if (pipelined)
+        publish_event(&e);
+    else
+        write_event(&e);
+    if (servicePath != NULL)
+        service_event(&e);
+}
+
+// Reports the memory held by every scheduler queue and the program store, now and at its peak, and the peak RSS
+void report_memory()
+{
+    Queue_memory m;
+    struct rusage usage;
+
+    printf("Memory (bytes requested from malloc, now and at the peak):\n");
+    report_queue_memory(stdout);
+    iowait_memory(&IOQueue, &m);
+    print_queue_memory(stdout, "IOQueue", &m);
+    deadline_queue_memory(&RealTimeQueue, &m);
+    print_queue_memory(stdout, "RealTimeQueue", &m);
+    behavior_program_memory(&m);
+    print_queue_memory(stdout, "Programs", &m);
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        printf("Peak resident set size: %ld kB\n", usage.ru_maxrss);
 }
 
 void final_report()
 {
+    int c;
+
     printf("Scheduler shutdown at time %d.\n", CPUclock - 1);
     printf("Total CPU usage for all processes scheduled:\n");
     printf("Process <<null>>:\t%d time units.\n", IdleProcess.CPU_Usage - 1);
-    puts(report);
+    rewind(report);
+    while ((c = getc(report)) != EOF)
+        putchar(c);
+    putchar('\n');
+
+    if (reportStarvation)
+    {
+        if (boostInterval > 0)
+            printf("Priority boost every %d ticks: %u boosts, %lu processes boosted.\n", boostInterval, boostEpoch, boostedProcesses);
+        else
+            printf("Priority boost disabled.\n");
+        printf("Ready-queue wait: %lu dispatches, average %.2f ticks, longest %u ticks (process %u).\n", dispatches,
+               dispatches ? (double)totalReadyWait / dispatches : 0.0, maxReadyWait, maxReadyWaitPID);
+    }
+
+    if (realTimeAdmitted + realTimeRejected > 0)
+    {
+        printf("Real-time class: %lu processes admitted, %lu rejected by admission control.\n", realTimeAdmitted, realTimeRejected);
+        printf("Deadlines: %lu CPU bursts, %lu missed", realTimeBursts, deadlineMisses);
+        if (deadlineMisses > 0)
+            printf(", worst lateness %lu ticks (process %u)", worstLateness, worstLatenessPID);
+        printf(".\n");
+    }
+
+    if (switchCost > 0 || warmupHorizon > 0)
+        printf("Context switches: %lu dispatches, %lu switches, %lu ticks lost (%lu switching, %lu warming caches), %.2f%% of the CPU time.\n",
+               dispatches, switches, switchLost + warmupLost, switchLost, warmupLost,
+               CPUclock > 1 ? 100.0 * (switchLost + warmupLost) / (CPUclock - 1) : 0.0);
+
+    if (memoryReport)
+        report_memory();
 }
 
-// Helper function to check if all level queues are empty
+// Copies the scheduler counters into the live metrics segment
+void publish_live_metrics(int finished)
+{
+    static struct timespec lastPublish; // wall clock time and event count of the previous publish
+    static unsigned long lastEvents = 0;
+    static int published = FALSE;
+    struct timespec now;
+    double seconds;
+    MetricsValues v;
+
+    v.CPUclock = CPUclock;
+    v.readyLength[0] = queue_length(&HighQueue);
+    v.readyLength[1] = queue_length(&MediumQueue);
+    v.readyLength[2] = queue_length(&LowQueue);
+    v.IOLength = iowait_length(&IOQueue);
+    v.idleTicks = IdleProcess.CPU_Usage;
+    v.contextSwitches = switches;
+    v.dispatches = dispatches;
+    v.promotions = promotions;
+    v.demotions = demotions;
+    v.events = eventsWritten;
+    v.finished = finished;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    seconds = (now.tv_sec - lastPublish.tv_sec) + (now.tv_nsec - lastPublish.tv_nsec) / 1e9;
+    v.eventsPerSecond = published && seconds > 0 ? (eventsWritten - lastEvents) / seconds : 0;
+    lastPublish = now;
+    lastEvents = eventsWritten;
+    published = TRUE;
+
+    publish_metrics(metrics, &v);
+}
+
+// Helper function to check if all level queues and the real-time queue are empty
 int all_queues_empty()
 {
-    return (empty_queue(&HighQueue) && empty_queue(&MediumQueue) && empty_queue(&LowQueue));
+    return (empty_queue(&HighQueue) && empty_queue(&MediumQueue) && empty_queue(&LowQueue) && deadline_queue_length(&RealTimeQueue) == 0);
 }
 
 /* A process exists when one of the following condition is true:
@@ -77,15 +298,70 @@ int all_queues_empty()
    IOQueue is not empty.
    ArrivalQueue is not empty.
    Currently executed process is not <<null>> process
+   In pipelined mode, the reader thread has more trace records
 */
 int processes_exist()
 {
-    return (!all_queues_empty() || !empty_queue(&IOQueue) || !empty_queue(&ArrivalQueue) || process_compare(&IdleProcess, exeProcess));
+    return (!all_queues_empty() || iowait_length(&IOQueue) > 0 || !empty_queue(&ArrivalQueue) || process_compare(&IdleProcess, exeProcess) ||
+            (pipelined && peek_trace_record() != NULL));
+}
+
+/* Service mode: admits the processes submitted since the last poll, at
+   their arrival time or at the next tick if that has passed.  Clients
+   are polled every SERVICE_POLL_TICKS ticks while the scheduler is
+   busy; an idle scheduler waits for a submission instead of ticking,
+   so the clock only runs while there is work.  Returns TRUE while
+   there is work, FALSE once the service shuts down with none left.
+*/
+int serve_submissions(void)
+{
+    IngestTable table;
+    int busy = processes_exist();
+
+    if (busy && CPUclock % SERVICE_POLL_TICKS != 0)
+        return TRUE;
+
+    init_ingest_table(&table);
+    do
+        poll_service(&table, busy ? 0 : -1);
+    while (table.count == 0 && !busy && !service_shutdown_requested());
+
+    if (table.count > 0)
+    {
+        queue_ingested_processes(&table);
+        busy = TRUE;
+    }
+    destroy_ingest_table(&table);
+    return busy;
+}
+
+/* Lazily applies a priority boost the process missed since it was last
+   stamped: the process returns to level 1 with the initial quantum and
+   factors.  Boosting costs O(1) because only a global epoch is bumped
+   every boostInterval ticks.  Returns TRUE if the process changed level.
+*/
+int apply_pending_boost(Process *p)
+{
+    if (p->boostEpoch == boostEpoch)
+        return FALSE;
+
+    p->boostEpoch = boostEpoch;
+    if (p->priority <= 1) // already at level 1, or real-time
+        return FALSE;
+
+    reset_to_top_level(p);
+    boostedProcesses++;
+    return TRUE;
 }
 
 void add_to_scheduling_queue(Process *p)
 {
-    if (p->priority == 1)
+    apply_pending_boost(p);
+    p->readyTime = CPUclock;
+
+    if (p->priority == 0)
+        add_to_deadline_queue(&RealTimeQueue, p);
+    else if (p->priority == 1)
         add_to_queue(&HighQueue, p, p->quantum);
     else if (p->priority == 2)
         add_to_queue(&MediumQueue, p, p->quantum);
@@ -93,90 +369,268 @@ void add_to_scheduling_queue(Process *p)
         add_to_queue(&LowQueue, p, p->quantum);
 }
 
-void queue_new_arrivals()
+/* Chooses the level queue whose front process runs next and stores the
+   effective level of that process in 'level'.  A process still stamped
+   with an older boost epoch counts as level 1.  Such processes were
+   queued before the boost, so they sit at the front of their queues and
+   are taken High, Medium, Low, which is the order a real boost would
+   have appended them to HighQueue.  Returns NULL if all level queues
+   are empty.
+*/
+Queue *select_ready_queue(unsigned int *level)
 {
-    Process currentProcess;
-    init_process(&currentProcess);
+    Queue *levelQueues[3] = {&HighQueue, &MediumQueue, &LowQueue};
+    const Process *front;
+    int i;
 
-    // Peek at the front element of the ArrivalQueue
-    rewind_queue(&ArrivalQueue);
-    peek_at_current(&ArrivalQueue, &currentProcess);
+    if (boostEpoch > 0)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            front = peek_front(levelQueues[i], NULL);
+            if (front != NULL && front->boostEpoch != boostEpoch)
+            {
+                *level = 1;
+                return levelQueues[i];
+            }
+        }
+    }
 
-    if (CPUclock == currentProcess.arrival_time)
+    for (i = 0; i < 3; i++)
     {
-        remove_from_front(&ArrivalQueue, &currentProcess);
+        if (!empty_queue(levelQueues[i]))
+        {
+            *level = i + 1;
+            return levelQueues[i];
+        }
+    }
+    return NULL;
+}
+
+/* Returns the ticks process 'p' needs to reload its working set when
+   dispatched now.  The share of the working set lost grows linearly
+   with the time the process was off the CPU, the whole of it after
+   warmupHorizon ticks or if the process never ran.
+*/
+unsigned long warmup_cost(const Process *p)
+{
+    unsigned long away;
 
-        // Poulate the process's fields with the dequeued behavior.
-        ProcessBehavior behavior;
-        remove_from_front(&(currentProcess.Behaviors), &behavior);
-        currentProcess.CPUTime = behavior.CPUBurst;
-        currentProcess.saveCPUTime = behavior.CPUBurst;
-        currentProcess.IOTime = behavior.IOBurst;
-        currentProcess.saveIOTime = behavior.IOBurst;
-        currentProcess.repeat = behavior.repeat;
+    if (warmupHorizon == 0 || p->workingSet == 0)
+        return 0;
+    if (p->CPU_Usage == 0)
+        return p->workingSet;
 
-        add_to_scheduling_queue(&currentProcess);
-        printf("CREATE: Process %d entered the ready queue at time %d\n", currentProcess.PID, CPUclock);
+    away = CPUclock - p->lastRunTime;
+    if (away >= warmupHorizon)
+        return p->workingSet;
+    return (p->workingSet * away + warmupHorizon - 1) / warmupHorizon;
+}
+
+/* The executing process was just dispatched: the CPU spends this tick
+   switching to it or reloading its working set.  The process makes no
+   progress and its quantum is not charged, so it may still be
+   preempted before it runs.
+*/
+void spend_switch_tick()
+{
+    if (switchTicks > 0)
+    {
+        switchTicks--;
+        switchLost++;
+    }
+    else
+    {
+        warmupTicks--;
+        warmupLost++;
     }
+    result = NOT_FINISH;
 }
 
-void demote_process(Process *p)
+// Makes frontReadyQ the executing process and records how long it waited
+void dispatch_front_process()
 {
-    p->priority++;
+    unsigned int wait;
+
+    apply_pending_boost(&frontReadyQ);
+    wait = CPUclock - frontReadyQ.readyTime;
+    dispatches++;
+    totalReadyWait += wait;
+    if (wait > maxReadyWait)
+    {
+        maxReadyWait = wait;
+        maxReadyWaitPID = frontReadyQ.PID;
+    }
 
-    // reset demoteFactor, promoteFactor, quantum coressponding to priority
-    if (p->priority == 2)
+    higherPriority = frontReadyQ;
+    exeProcess = &higherPriority;
+    quantum = exeProcess->quantum;
+    if (exeProcess->priority == 0)
+        quantum = exeProcess->CPUTime; // real-time processes keep the CPU for their whole burst unless preempted
+    // only replacing another process's context is a switch: the first dispatch and
+    // dispatching the process that ran last, e.g. after its quantum expired or when
+    // the CPU was idle since it ran, are not
+    if (dispatchedBefore && exeProcess->PID != lastDispatchedPID)
     {
-        p->demoteFactor = 2;
-        p->promoteFactor = 2;
-        p->quantum = 30;
+        switches++;
+        switchTicks = switchCost;
     }
     else
+        switchTicks = 0;
+    dispatchedBefore = TRUE;
+    lastDispatchedPID = exeProcess->PID;
+    warmupTicks = warmup_cost(exeProcess);
+    emit_event(EVENT_RUN, exeProcess);
+}
+
+// Returns the longest CPU burst of process 'p'
+unsigned long longest_cpu_burst(const Process *p)
+{
+    unsigned long i, longest = 0;
+
+    for (i = 0; i < p->program->length; i++)
+    {
+        if (p->program->behaviors[i].CPUBurst > longest)
+            longest = p->program->behaviors[i].CPUBurst;
+    }
+    return longest;
+}
+
+/* Returns the CPU share a real-time process needs: its density, the
+   longest CPU burst over the shorter of its relative deadline and its
+   period.  The burst must be done within the deadline even when the
+   period is longer, so C/P alone would admit sets that miss.
+*/
+double real_time_utilization(const Process *p)
+{
+    unsigned long window = p->relativeDeadline;
+
+    if (p->period > 0 && p->period < window)
+        window = p->period;
+    return (double)longest_cpu_burst(p) / window;
+}
+
+/* Admission control for an arriving process with a deadline: it joins
+   the real-time class if the total density of the class stays at most
+   1, where EDF meets every deadline on one CPU.  A process that does
+   not fit, or with a CPU burst longer than its deadline, which it can
+   never meet, runs as an ordinary MLFQ process instead.
+*/
+void admit_real_time_process(Process *p)
+{
+    double u;
+
+    if (p->relativeDeadline == 0)
+        return;
+
+    u = real_time_utilization(p);
+    if (longest_cpu_burst(p) > p->relativeDeadline || realTimeUtilization + u > 1.0 + 1e-9)
     {
-        p->promoteFactor = 1;
-        p->quantum = 100;
+        p->relativeDeadline = 0;
+        realTimeRejected++;
+        return;
     }
+    realTimeUtilization += u;
+    realTimeAdmitted++;
+    p->priority = 0;
 }
 
-void promote_process(Process *p)
+// A real-time process starts a CPU burst, due 'relativeDeadline' ticks from now
+void release_real_time_burst(Process *p)
 {
-    p->priority--;
-    // reset demoteFactor, promoteFactor, quantum coressponding to priority
-    if (p->priority == 2)
+    if (p->priority == 0)
+        p->deadline = CPUclock + p->relativeDeadline;
+}
+
+// A real-time process completed its CPU burst, checks it against its deadline
+void complete_real_time_burst(Process *p)
+{
+    realTimeBursts++;
+    if ((unsigned long)CPUclock <= p->deadline)
+        return;
+
+    deadlineMisses++;
+    if (CPUclock - p->deadline > worstLateness)
     {
-        p->demoteFactor = 2;
-        p->promoteFactor = 2;
-        p->quantum = 30;
+        worstLateness = CPUclock - p->deadline;
+        worstLatenessPID = p->PID;
     }
-    else
+    emit_event(EVENT_DEADLINE_MISS, p);
+}
+
+/* Returns TRUE if the real-time process with the earliest deadline
+   should preempt the executing process: any MLFQ process, or a
+   real-time process due later
+*/
+int real_time_preempts(const Process *p)
+{
+    const Process *front = peek_earliest_deadline(&RealTimeQueue);
+
+    return front != NULL && (p->priority > 0 || front->deadline < p->deadline);
+}
+
+// Puts the executing process back in its queue and dispatches frontReadyQ
+void preempt_executing_process()
+{
+    emit_event(EVENT_PREEMPT, exeProcess);
+    emit_event(EVENT_QUEUED, exeProcess);
+    exeProcess->quantum = quantum;
+    add_to_scheduling_queue(exeProcess);
+
+    dispatch_front_process();
+}
+
+void queue_new_arrivals()
+{
+    const Process *nextArrival;
+    Process currentProcess;
+    PROFILE_SCOPE(PHASE_ARRIVALS);
+
+    // Admit every process whose arrival time has come, inspecting the front of the ArrivalQueue in place
+    while ((nextArrival = peek_front(&ArrivalQueue, NULL)) != NULL && nextArrival->arrival_time <= (unsigned int)CPUclock)
     {
-        p->demoteFactor = 1;
-        p->quantum = 10;
+        remove_from_front(&ArrivalQueue, &currentProcess);
+
+        // Poulate the process's fields with the first behavior of its program.
+        load_next_behavior(&currentProcess);
+        admit_real_time_process(&currentProcess);
+        release_real_time_burst(&currentProcess);
+
+        add_to_scheduling_queue(&currentProcess);
+        emit_event(EVENT_CREATE, &currentProcess);
     }
 }
 
+// Counts and reports process 'p' moving down a level
+void record_demotion(const Process *p)
+{
+    demotions++;
+    emit_event(EVENT_DEMOTE, p);
+}
+
+// Counts and reports process 'p' moving up a level
+void record_promotion(const Process *p)
+{
+    promotions++;
+    emit_event(EVENT_PROMOTE, p);
+}
+
 void execute_highest_priority_process()
 {
+    Queue *readyQueue;
+    unsigned int level;
+    PROFILE_SCOPE(PHASE_EXECUTE);
+
     // CASE 1: quantum is 0, but not finish
     if (quantum == 0)
     {
         if (result == NOT_FINISH)
         {
-            // demote process for priority 1 & 2
-            if (exeProcess->priority < 3)
-            {
-                exeProcess->demoteFactor--;
-                if (exeProcess->demoteFactor == 0)
-                {
-                    demote_process(exeProcess);
-                }
-            }
-            // reset quantum for priority 3
-            else
-                exeProcess->quantum = 100;
+            if (quantum_expired(exeProcess))
+                record_demotion(exeProcess);
 
             add_to_scheduling_queue(exeProcess);
-            printf("QUEUED: Process %d queued at level %d at time %d.\n", exeProcess->PID, exeProcess->priority, CPUclock);
+            emit_event(EVENT_QUEUED, exeProcess);
             exeProcess = &IdleProcess;
         }
     }
@@ -185,21 +639,14 @@ void execute_highest_priority_process()
     // action: decrease promoteFactor, when 0 then promote
     if (result == DO_IO)
     {
-        // promote process for priority 2 & 3
-        if (exeProcess->priority > 1)
-        {
-            exeProcess->promoteFactor--;
-            if (exeProcess->promoteFactor == 0)
-            {
-                promote_process(exeProcess);
-            }
-        }
-        // reset quantum for priority 1
-        else
-            exeProcess->quantum = 10;
+        if (exeProcess->priority == 0)
+            complete_real_time_burst(exeProcess);
 
-        printf("I/O: Process %d blocked for I/O at time %d.\n", exeProcess->PID, CPUclock);
-        add_to_queue(&IOQueue, exeProcess, 1);
+        if (blocked_for_io(exeProcess))
+            record_promotion(exeProcess);
+
+        emit_event(EVENT_IO, exeProcess);
+        add_to_iowait_set(&IOQueue, exeProcess);
         exeProcess = &IdleProcess;
     }
 
@@ -208,110 +655,212 @@ void execute_highest_priority_process()
     {
         if (process_compare(&IdleProcess, exeProcess))
         {
-            char process_report[50];
-            printf("FINISHED: Process %d finished at time %d.\n", exeProcess->PID, CPUclock);
-            sprintf(process_report, "Process %d:\t\t%d time units.\n", exeProcess->PID, exeProcess->CPU_Usage);
-            strcat(report, process_report);
+            if (exeProcess->priority == 0)
+            {
+                complete_real_time_burst(exeProcess);
+                realTimeUtilization -= real_time_utilization(exeProcess);
+            }
+            emit_event(EVENT_FINISHED, exeProcess);
+            fprintf(report, "Process %d:\t\t%d time units.\n", exeProcess->PID, exeProcess->CPU_Usage);
+            release_process(exeProcess);
             exeProcess = &IdleProcess;
         }
     }
 
-    // When exeProcess is <<null>> process, choose to execute the process in the front Queues in order high med low
+    // When exeProcess is <<null>> process, choose to execute the real-time process with the earliest deadline,
+    // otherwise the process in the front Queues in order high med low
     if (!process_compare(&IdleProcess, exeProcess))
     {
-        if (!all_queues_empty())
+        if (remove_earliest_deadline(&RealTimeQueue, &frontReadyQ))
+            dispatch_front_process();
+        else if ((readyQueue = select_ready_queue(&level)) != NULL)
         {
-            if (!empty_queue(&HighQueue))
-            {
-                remove_from_front(&HighQueue, &frontReadyQ);
-            }
-            else if (!empty_queue(&MediumQueue))
-            {
-                remove_from_front(&MediumQueue, &frontReadyQ);
-            }
-            else if (!empty_queue(&LowQueue))
-            {
-                remove_from_front(&LowQueue, &frontReadyQ);
-            }
-
-            higherPriority = frontReadyQ;
-            exeProcess = &higherPriority;
-            quantum = exeProcess->quantum;
-            printf("RUN: Process %d started execution from level %d at time %d; wants to execute for %lu ticks.\n", exeProcess->PID, exeProcess->priority, CPUclock, exeProcess->CPUTime);
+            remove_from_front(readyQueue, &frontReadyQ);
+            dispatch_front_process();
         }
     }
     // When exeProcess is not <<null>> process, look for higher priority process
     else
     {
-        if (!empty_queue(&HighQueue) || !empty_queue(&MediumQueue))
-        {
-            if (!empty_queue(&HighQueue) && exeProcess->priority > 1)
-            {
-                remove_from_front(&HighQueue, &frontReadyQ);
-            }
-            else if (!empty_queue(&MediumQueue) && exeProcess->priority > 2)
-            {
-                remove_from_front(&MediumQueue, &frontReadyQ);
-            }
+        // a boost that happened while the process was running also applies to it
+        if (apply_pending_boost(exeProcess) && quantum > (int)exeProcess->quantum)
+            quantum = exeProcess->quantum;
 
-            // This condition only met when successfully remove front process in either High/Med priority queues
-            if (exeProcess->priority > frontReadyQ.priority)
-            {
-                printf("QUEUED: Process %d queued at level %d at time %d.\n", exeProcess->PID, exeProcess->priority, CPUclock);
-                exeProcess->quantum = quantum;
-                add_to_scheduling_queue(exeProcess);
-
-                higherPriority = frontReadyQ;
-                exeProcess = &higherPriority;
-                quantum = exeProcess->quantum;
-                printf("RUN: Process %d started execution from level %d at time %d; wants to execute for %lu ticks.\n", exeProcess->PID, exeProcess->priority, CPUclock, exeProcess->CPUTime);
-            }
+        if (real_time_preempts(exeProcess))
+        {
+            remove_earliest_deadline(&RealTimeQueue, &frontReadyQ);
+            preempt_executing_process();
+        }
+        else if ((readyQueue = select_ready_queue(&level)) != NULL && level < exeProcess->priority)
+        {
+            remove_from_front(readyQueue, &frontReadyQ);
+            preempt_executing_process();
         }
     }
 
-    result = exec_process(exeProcess);
-    quantum--;
+    if (switchTicks + warmupTicks > 0)
+        spend_switch_tick();
+    else
+    {
+        result = exec_process(exeProcess);
+        exeProcess->lastRunTime = CPUclock;
+        quantum--;
+    }
 }
 
 void do_io_for_processes()
 {
-    if (!empty_queue(&IOQueue))
+    Process *completed;
+    unsigned long finished, i;
+    PROFILE_SCOPE(PHASE_IO);
+
+    // Every visited process does 1 tick of IO. The pass stops once it has visited as many
+    // processes as are still blocked, the ones behind that point wait until the next tick.
+    finished = do_iowait_tick(&IOQueue, &completed);
+
+    // Processes that finished IO go back to the readyQ in the order they were visited
+    for (i = 0; i < finished; i++)
     {
-        Process IOProcess;
-        init_process(&IOProcess);
-        for (int i = 0; i < IOQueue.queuelength; i++)
-        {
-            remove_from_front(&IOQueue, &IOProcess);
-            int result = do_IO(&IOProcess);
-
-            // If finish IO, add back to readyQ
-            if (result != FINISH)
-                add_to_queue(&IOQueue, &IOProcess, 1);
-            else
-                add_to_scheduling_queue(&IOProcess);
-        }
+        emit_event(EVENT_IO_DONE, &completed[i]);
+        release_real_time_burst(&completed[i]);
+        add_to_scheduling_queue(&completed[i]);
     }
-    else
-        return;
 }
 
 int main(int argc, char *argv[])
 {
+    unsigned int cpus = 0, threads = 1, lookahead = DEFAULT_LOOKAHEAD;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:c:j:m:n:ps:t:w:MW:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            pipelined = TRUE;
+            break;
+        case 'M':
+            memoryReport = TRUE;
+            break;
+        case 'b':
+            boostInterval = atoi(optarg);
+            reportStarvation = TRUE;
+            break;
+        case 'm':
+            metricsName = optarg;
+            metrics = create_metrics(metricsName);
+            if (metrics == NULL)
+            {
+                perror(metricsName);
+                return 1;
+            }
+            break;
+        case 's':
+            servicePath = optarg;
+            break;
+        case 'c':
+            switchCost = strtoul(optarg, NULL, 10);
+            break;
+        case 'W':
+            warmupHorizon = strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            cpus = strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            threads = strtoul(optarg, NULL, 10);
+            break;
+        case 'w':
+            lookahead = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            if (open_timeline(optarg) != 0)
+            {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-p] [-b boost_interval] [-c switch_cost] [-W warmup_horizon] [-t timeline.json] [-m metrics_name] [-M] < trace\n"
+                            "       %s -s socket_path [-b boost_interval] [-c switch_cost] [-W warmup_horizon] [-t timeline.json] [-m metrics_name] [-M]\n"
+                            "       %s -n cpus [-j threads] [-w lookahead] < trace\n",
+                    argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (servicePath != NULL && pipelined)
+    {
+        fprintf(stderr, "%s: -p and -s cannot be combined\n", argv[0]);
+        return 1;
+    }
+    if (cpus > 0)
+    {
+        if (pipelined || servicePath != NULL || boostInterval > 0 || timeline_open() || metrics != NULL || memoryReport ||
+            switchCost > 0 || warmupHorizon > 0)
+        {
+            fprintf(stderr, "%s: -n cannot be combined with -p, -s, -b, -c, -t, -m, -M or -W\n", argv[0]);
+            close_timeline();
+            if (metrics != NULL)
+                detach_metrics(metrics, metricsName);
+            return 1;
+        }
+        return run_multicpu_simulation(cpus, threads, lookahead);
+    }
+
+    report = tmpfile();
+    if (report == NULL)
+    {
+        perror("tmpfile");
+        return 1;
+    }
+
     init_all_queues();
     init_process(&IdleProcess);
     exeProcess = &IdleProcess;
     init_process(&frontReadyQ);
     init_process(&higherPriority);
-    read_process_descriptions();
+    if (servicePath != NULL)
+    {
+        if (open_service(servicePath) != 0)
+        {
+            perror(servicePath);
+            return 1;
+        }
+    }
+    else if (pipelined)
+        start_pipeline();
+    else
+        read_process_descriptions();
 
-    while (processes_exist())
+    while (servicePath != NULL ? serve_submissions() : processes_exist())
     {
         CPUclock++;
+        if (boostInterval > 0 && CPUclock % boostInterval == 0)
+            boostEpoch++;
+        if (pipelined)
+            read_pipelined_arrivals();
         queue_new_arrivals();
         execute_highest_priority_process();
         do_io_for_processes();
+        if (metrics != NULL && CPUclock % METRICS_INTERVAL == 0)
+            publish_live_metrics(FALSE);
     };
     CPUclock++;
+    if (pipelined)
+        stop_pipeline();
+    if (servicePath != NULL)
+        close_service();
+    close_timeline();
+    if (metrics != NULL)
+    {
+        publish_live_metrics(TRUE);
+        detach_metrics(metrics, metricsName);
+    }
     final_report();
+    PROFILE_REPORT(stderr); // stderr keeps the scheduler output unchanged
+
+    fclose(report);
+    destroy_all_queues();
+    destroy_behavior_programs();
     return 0;
 }
\ No newline at end of file
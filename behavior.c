@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "behavior.h"
+
+// Open addressing intern table of programs, linear probing, size is a power of 2
+static BehaviorProgram **programTable = NULL;
+static unsigned long tableSize = 0;
+static unsigned long programCount = 0;
+static unsigned long programBytes = 0;                   // bytes of the table and the programs
+static unsigned long peakProgramCount = 0, peakProgramBytes = 0; // programCount and programBytes at the peak of programBytes
+
+// FNV-1a over the behavior fields (not the struct bytes, which contain padding)
+static unsigned long hash_behaviors(const ProcessBehavior *behaviors, unsigned long length)
+{
+    unsigned long hash = 14695981039346656037UL;
+    unsigned long fields[3];
+    unsigned long i;
+    int j;
+
+    for (i = 0; i < length; i++)
+    {
+        fields[0] = behaviors[i].CPUBurst;
+        fields[1] = behaviors[i].IOBurst;
+        fields[2] = behaviors[i].repeat;
+        for (j = 0; j < 3; j++)
+        {
+            hash ^= fields[j];
+            hash *= 1099511628211UL;
+        }
+    }
+    return hash ^ length;
+}
+
+static int same_behaviors(const BehaviorProgram *program, const ProcessBehavior *behaviors, unsigned long length)
+{
+    unsigned long i;
+
+    if (program->length != length)
+        return 0;
+    for (i = 0; i < length; i++)
+    {
+        if (program->behaviors[i].CPUBurst != behaviors[i].CPUBurst ||
+            program->behaviors[i].IOBurst != behaviors[i].IOBurst ||
+            program->behaviors[i].repeat != behaviors[i].repeat)
+            return 0;
+    }
+    return 1;
+}
+
+static void add_program_bytes(unsigned long bytes)
+{
+    programBytes += bytes;
+    if (programBytes > peakProgramBytes)
+    {
+        peakProgramBytes = programBytes;
+        peakProgramCount = programCount;
+    }
+}
+
+static void grow_program_table(void)
+{
+    BehaviorProgram **oldTable = programTable;
+    unsigned long oldSize = tableSize;
+    unsigned long i, slot;
+
+    tableSize = oldSize ? oldSize * 2 : 1024;
+    programTable = calloc(tableSize, sizeof(BehaviorProgram *));
+    if (programTable == NULL)
+    {
+        fprintf(stderr, "calloc() failed in function intern_behavior_program()\n");
+        exit(1);
+    }
+
+    for (i = 0; i < oldSize; i++)
+    {
+        if (oldTable[i] != NULL)
+        {
+            slot = oldTable[i]->hash & (tableSize - 1);
+            while (programTable[slot] != NULL)
+                slot = (slot + 1) & (tableSize - 1);
+            programTable[slot] = oldTable[i];
+        }
+    }
+    free(oldTable);
+    add_program_bytes((tableSize - oldSize) * sizeof(BehaviorProgram *));
+}
+
+const BehaviorProgram *intern_behavior_program(const ProcessBehavior *behaviors, unsigned long length)
+{
+    unsigned long hash, slot;
+    BehaviorProgram *program;
+
+    // keep the load factor at most 1/2
+    if (2 * (programCount + 1) > tableSize)
+        grow_program_table();
+
+    hash = hash_behaviors(behaviors, length);
+    slot = hash & (tableSize - 1);
+    while (programTable[slot] != NULL)
+    {
+        if (programTable[slot]->hash == hash && same_behaviors(programTable[slot], behaviors, length))
+        {
+            programTable[slot]->references++;
+            return programTable[slot];
+        }
+        slot = (slot + 1) & (tableSize - 1);
+    }
+
+    program = malloc(sizeof(BehaviorProgram) + length * sizeof(ProcessBehavior));
+    if (program == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function intern_behavior_program()\n");
+        exit(1);
+    }
+    program->hash = hash;
+    program->length = length;
+    program->references = 1;
+    memcpy(program->behaviors, behaviors, length * sizeof(ProcessBehavior));
+
+    programTable[slot] = program;
+    programCount++;
+    add_program_bytes(sizeof(BehaviorProgram) + length * sizeof(ProcessBehavior));
+    return program;
+}
+
+void release_behavior_program(const BehaviorProgram *program)
+{
+    unsigned long slot, next, home;
+
+    if (program == NULL || --((BehaviorProgram *)program)->references > 0)
+        return;
+
+    slot = program->hash & (tableSize - 1);
+    while (programTable[slot] != program)
+        slot = (slot + 1) & (tableSize - 1);
+    programBytes -= sizeof(BehaviorProgram) + program->length * sizeof(ProcessBehavior);
+    free(programTable[slot]);
+    programTable[slot] = NULL;
+    programCount--;
+
+    // backward shift deletion: move later entries of the probe run into
+    // the hole unless their home slot lies cyclically after the hole
+    next = (slot + 1) & (tableSize - 1);
+    while (programTable[next] != NULL)
+    {
+        home = programTable[next]->hash & (tableSize - 1);
+        if (((next - home) & (tableSize - 1)) >= ((next - slot) & (tableSize - 1)))
+        {
+            programTable[slot] = programTable[next];
+            programTable[next] = NULL;
+            slot = next;
+        }
+        next = (next + 1) & (tableSize - 1);
+    }
+}
+
+unsigned long behavior_program_count(void)
+{
+    return programCount;
+}
+
+void behavior_program_memory(Queue_memory *m)
+{
+    m->nodes = programCount;
+    m->bytes = programBytes;
+    m->peak_nodes = peakProgramCount;
+    m->peak_bytes = peakProgramBytes;
+}
+
+void destroy_behavior_programs(void)
+{
+    unsigned long i;
+
+    for (i = 0; i < tableSize; i++)
+        free(programTable[i]);
+    free(programTable);
+    programTable = NULL;
+    tableSize = 0;
+    programCount = 0;
+    programBytes = 0;
+}
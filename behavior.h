@@ -0,0 +1,52 @@
+#if !defined(BEHAVIOR_TYPE_DEFINED)
+#define BEHAVIOR_TYPE_DEFINED
+
+#include "prioque.h"
+
+// Struct of a behavior of a process
+typedef struct ProcessBehavior
+{
+    long unsigned int CPUBurst;
+    long unsigned int IOBurst;
+    unsigned int repeat;
+} ProcessBehavior;
+
+/* Immutable sequence of behaviors executed by a process.
+   Programs are interned by content, so processes with identical
+   behaviors share one program and only keep a cursor into it.
+*/
+typedef struct BehaviorProgram
+{
+    unsigned long hash;          // content hash used by the intern table
+    unsigned long length;        // number of behaviors in the program
+    unsigned long references;    // number of processes holding the program
+    ProcessBehavior behaviors[]; // the behaviors, in execution order
+} BehaviorProgram;
+
+/* returns the interned program holding a copy of the 'length' behaviors
+   in 'behaviors'.  If an identical program was interned before, that
+   program is returned and no memory is allocated.  Every call takes a
+   reference that must be dropped with release_behavior_program().
+*/
+const BehaviorProgram *intern_behavior_program(const ProcessBehavior *behaviors, unsigned long length);
+
+/* drops a reference taken by intern_behavior_program(), the program is
+   freed when its last reference is dropped.  'program' may be NULL.
+*/
+void release_behavior_program(const BehaviorProgram *program);
+
+/* returns the number of distinct programs currently interned
+*/
+unsigned long behavior_program_count(void);
+
+/* stores the memory held by the intern table and its programs in 'm',
+   one node per program, now and at the peak of the bytes held
+*/
+void behavior_program_memory(Queue_memory *m);
+
+/* frees every interned program regardless of references, all program
+   pointers become invalid
+*/
+void destroy_behavior_programs(void);
+
+#endif
@@ -0,0 +1,75 @@
+#!/bin/sh
+# churn_check.sh: checks that a long run where processes keep starting
+# and finishing holds no more memory than a short one.
+#
+#   usage: ./churn_check.sh [path/to/mlfqs]
+#
+# Generates churn traces of SHORT_PROCESSES and LONG_PROCESSES processes
+# that arrive one every ARRIVAL_GAP ticks, each a few CPU and IO bursts
+# long, so only a handful are alive at any time; the long trace runs
+# for over LONG_TICKS ticks.  Their behaviors cycle through about 1300
+# distinct programs, more than are ever alive at once.  Both traces run
+# in pipelined mode with the memory report (-p -M), which reads the
+# trace as it goes, and the check fails unless
+#   o every process finished, and the long run lasted LONG_TICKS
+#   o no program is left interned at shutdown (no reference leaked)
+#   o the program store and the peak RSS of the long run stay within
+#     RSS_SLACK_KB of the short run
+# Build mlfqs without sanitizers: AddressSanitizer's quarantine makes
+# the RSS grow with the number of frees.
+
+MLFQS=${1:-./mlfqs}
+ARRIVAL_GAP=200 # ticks between two arrivals, above the average CPU time of a process
+SHORT_PROCESSES=20000
+LONG_PROCESSES=500000 # LONG_PROCESSES * ARRIVAL_GAP ticks
+LONG_TICKS=100000000
+RSS_SLACK_KB=512
+
+# churn_trace N: N processes, one behavior line each
+churn_trace()
+{
+    awk -v n="$1" -v gap="$ARRIVAL_GAP" 'BEGIN {
+        for (i = 1; i <= n; i++)
+            printf "%d %d %d %d 2\n", i * gap, i, 3 + i % 97, 1 + int(i / 97) % 13
+    }'
+}
+
+# run_churn N: prints "finished ticks programs program_bytes rss_kb" for a run of N processes
+run_churn()
+{
+    churn_trace "$1" | "$MLFQS" -p -M | awk '
+        /^FINISHED:/ { finished++ }
+        /^Scheduler shutdown at time/ { ticks = $5 + 0 }
+        /^Programs / { programs = $2; bytes = $4 }
+        /^Peak resident set size:/ { rss = $5 }
+        END { print finished + 0, ticks + 0, programs, bytes, rss }'
+}
+
+if [ ! -x "$MLFQS" ]; then
+    echo "churn_check: $MLFQS is not an executable" >&2
+    exit 2
+fi
+
+set -- $(run_churn $SHORT_PROCESSES) $(run_churn $LONG_PROCESSES)
+echo "$SHORT_PROCESSES processes: $1 finished in $2 ticks, $3 programs left, program store $4 bytes, peak RSS $5 kB"
+echo "$LONG_PROCESSES processes: $6 finished in $7 ticks, $8 programs left, program store $9 bytes, peak RSS ${10} kB"
+
+status=0
+if [ "$1" -ne $SHORT_PROCESSES ] || [ "$6" -ne $LONG_PROCESSES ]; then
+    echo "churn_check: not every process finished" >&2
+    status=1
+fi
+if [ "$7" -lt $LONG_TICKS ]; then
+    echo "churn_check: the long run ended after $7 ticks, before $LONG_TICKS" >&2
+    status=1
+fi
+if [ "$3" -ne 0 ] || [ "$8" -ne 0 ]; then
+    echo "churn_check: programs are still referenced at shutdown" >&2
+    status=1
+fi
+if [ "$9" -gt $(($4 + RSS_SLACK_KB * 1024)) ] || [ "${10}" -gt $(($5 + RSS_SLACK_KB)) ]; then
+    echo "churn_check: memory grew with the length of the run" >&2
+    status=1
+fi
+[ $status -eq 0 ] && echo "churn_check: OK"
+exit $status
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "coroutine.h"
+#include "mlfq.h"
+
+#define COROUTINE_EVENTS 64 // completed I/O operations collected per epoll_wait()
+
+// gives 'co' the quantum and factors of 'level' from the level tables in mlfq.c
+static void enter_level(Coroutine *co, unsigned int level)
+{
+    co->level = level;
+    co->quantum = levelQuantum[level - 1];
+    co->promoteFactor = levelPromoteFactor[level - 1];
+    co->demoteFactor = levelDemoteFactor[level - 1];
+}
+
+static void make_ready(Coroutine *co)
+{
+    add_to_queue(&(co->executor->levels[co->level - 1]), &co, 0);
+}
+
+void init_coroutine_executor(CoroutineExecutor *e)
+{
+    int i;
+
+    for (i = 0; i < COROUTINE_LEVELS; i++)
+        init_queue(&(e->levels[i]), sizeof(Coroutine *), TRUE, NULL, TRUE);
+    e->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (e->epollFd < 0)
+    {
+        perror("epoll_create1() failed in function init_coroutine_executor()");
+        exit(1);
+    }
+    e->waiting = 0;
+    e->live = 0;
+}
+
+Coroutine *spawn_coroutine(CoroutineExecutor *e, CoroutineBody body, void *arg)
+{
+    Coroutine *co = malloc(sizeof(Coroutine));
+
+    if (co == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function spawn_coroutine()\n");
+        exit(1);
+    }
+    co->body = body;
+    co->arg = arg;
+    co->executor = e;
+    co->resumePoint = 0;
+    co->waitFd = -1;
+    co->timerFd = -1;
+    co->events = 0;
+    enter_level(co, 1);
+
+    e->live++;
+    make_ready(co);
+    return co;
+}
+
+int await_fd(Coroutine *co, int fd, unsigned int events)
+{
+    struct epoll_event ev;
+
+    ev.events = events | EPOLLONESHOT;
+    ev.data.ptr = co;
+    if (epoll_ctl(co->executor->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        perror("epoll_ctl() failed in function await_fd()");
+        return -1;
+    }
+    co->waitFd = fd;
+    co->executor->waiting++;
+    return 0;
+}
+
+int await_sleep(Coroutine *co, unsigned long milliseconds)
+{
+    struct itimerspec timeout = {{0, 0}, {0, 0}};
+
+    if (co->timerFd < 0)
+    {
+        co->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (co->timerFd < 0)
+        {
+            perror("timerfd_create() failed in function await_sleep()");
+            return -1;
+        }
+    }
+    // a zero it_value disarms the timer, so a sleep lasts at least 1ns
+    timeout.it_value.tv_sec = milliseconds / 1000;
+    timeout.it_value.tv_nsec = (milliseconds % 1000) * 1000000 + 1;
+    if (timerfd_settime(co->timerFd, 0, &timeout, NULL) != 0)
+    {
+        perror("timerfd_settime() failed in function await_sleep()");
+        return -1;
+    }
+    return await_fd(co, co->timerFd, EPOLLIN);
+}
+
+// Moves the coroutines whose I/O completed back to their level queues, waiting up to 'timeout' ms
+static void resume_completed_io(CoroutineExecutor *e, int timeout)
+{
+    struct epoll_event events[COROUTINE_EVENTS];
+    unsigned long long expirations;
+    Coroutine *co;
+    int n, i;
+
+    n = epoll_wait(e->epollFd, events, COROUTINE_EVENTS, timeout);
+    for (i = 0; i < n; i++)
+    {
+        co = events[i].data.ptr;
+        co->events = events[i].events;
+        epoll_ctl(e->epollFd, EPOLL_CTL_DEL, co->waitFd, NULL);
+        // consume the expiration, or the next sleep would complete at once
+        if (co->waitFd == co->timerFd && read(co->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            co->events |= EPOLLERR;
+        co->waitFd = -1;
+        e->waiting--;
+        make_ready(co);
+    }
+}
+
+static void finish_coroutine(CoroutineExecutor *e, Coroutine *co)
+{
+    if (co->waitFd >= 0)
+    {
+        epoll_ctl(e->epollFd, EPOLL_CTL_DEL, co->waitFd, NULL);
+        e->waiting--;
+    }
+    if (co->timerFd >= 0)
+        close(co->timerFd);
+    free(co);
+    e->live--;
+}
+
+// Returns nonzero if a coroutine of a level above 'level' is ready
+static int higher_level_ready(CoroutineExecutor *e, unsigned int level)
+{
+    unsigned int i;
+
+    for (i = 0; i + 1 < level; i++)
+    {
+        if (!empty_queue(&(e->levels[i])))
+            return 1;
+    }
+    return 0;
+}
+
+/* Resumes 'co' until it finishes, awaits I/O, exhausts its quantum or
+   a coroutine of a higher level is ready, then applies the MLFQ rules
+*/
+static void run_coroutine(CoroutineExecutor *e, Coroutine *co)
+{
+    for (;;)
+    {
+        switch (co->body(co, co->arg))
+        {
+        case CO_DONE:
+            finish_coroutine(e, co);
+            return;
+        case CO_WAIT:
+            // awaiting I/O before the quantum ran out, promote levels 2 and 3
+            if (co->level > 1)
+            {
+                if (--co->promoteFactor == 0)
+                    enter_level(co, co->level - 1);
+            }
+            else
+                co->quantum = levelQuantum[0];
+            return;
+        }
+
+        if (--co->quantum == 0)
+        {
+            // exhausted the quantum, demote levels 1 and 2
+            if (co->level < COROUTINE_LEVELS && --co->demoteFactor == 0)
+                enter_level(co, co->level + 1);
+            else
+                co->quantum = levelQuantum[co->level - 1];
+            make_ready(co);
+            return;
+        }
+
+        // I/O that completed meanwhile may have readied a higher level, preempted coroutines keep their quantum
+        if (co->level > 1)
+        {
+            if (e->waiting > 0)
+                resume_completed_io(e, 0);
+            if (higher_level_ready(e, co->level))
+            {
+                make_ready(co);
+                return;
+            }
+        }
+    }
+}
+
+void run_coroutine_executor(CoroutineExecutor *e)
+{
+    Coroutine *co;
+    unsigned int i;
+
+    while (e->live > 0)
+    {
+        if (e->waiting > 0)
+            resume_completed_io(e, 0);
+
+        for (i = 0; i < COROUTINE_LEVELS; i++)
+        {
+            if (remove_from_front(&(e->levels[i]), &co) != NULL)
+                break;
+        }
+        if (i < COROUTINE_LEVELS)
+            run_coroutine(e, co);
+        else if (e->waiting > 0)
+            resume_completed_io(e, -1); // every live coroutine is parked
+        else
+        {
+            fprintf(stderr, "run_coroutine_executor(): live coroutines are neither ready nor parked\n");
+            exit(1);
+        }
+    }
+}
+
+void destroy_coroutine_executor(CoroutineExecutor *e)
+{
+    int i;
+
+    for (i = 0; i < COROUTINE_LEVELS; i++)
+        destroy_queue(&(e->levels[i]));
+    close(e->epollFd);
+}
@@ -0,0 +1,139 @@
+#if !defined(COROUTINE_TYPE_DEFINED)
+#define COROUTINE_TYPE_DEFINED
+
+#include "prioque.h"
+#include "mlfq.h"
+
+/* Single-threaded MLFQ executor for I/O bound tasks written as
+   stackless coroutines.  A coroutine body is a function that runs
+   from one suspension point to the next and returns; the CO_ macros
+   below record where it stopped and jump back there when it is
+   resumed (a switch on the line number, as protothreads do).  Locals
+   of the body do not survive a suspension, state that must live
+   across one belongs in the 'arg' the coroutine was spawned with.
+   Since the line number names the suspension point, only one of
+   CO_YIELD, CO_AWAIT_FD and CO_AWAIT_SLEEP may appear per source line
+   (two on one line fail to compile with "duplicate case value"), and
+   a body may not contain a switch statement of its own around them.
+
+       int echo(Coroutine *co, void *arg)
+       {
+           Connection *c = arg;
+
+           CO_BEGIN(co);
+           for (;;)
+           {
+               CO_AWAIT_FD(co, c->fd, EPOLLIN);
+               if (handle_input(c) == 0)
+                   break;
+               CO_YIELD(co);
+           }
+           CO_END(co);
+       }
+
+   Every resume is one step of the coroutine.  A coroutine starts at
+   level 1 and runs for the quantum of its level (10, 30 and 100
+   steps); the MLFQ rules of the simulator then apply: exhausting the
+   quantum counts towards a demotion (exec_process() returning
+   NOT_FINISH), awaiting I/O towards a promotion (DO_IO).  The quanta
+   and factors are the level tables of mlfq.h.  Awaiting
+   coroutines are parked on the executor's epoll instance and resume
+   in the level the rules chose once their file descriptor is ready or
+   their sleep is over.  A running coroutine is suspended after its
+   step when a coroutine of a higher level is ready.
+*/
+
+#define COROUTINE_LEVELS MLFQ_LEVELS
+
+// Return values of a coroutine body, produced by the CO_ macros
+#define CO_CONTINUE 0 // suspended at CO_YIELD, ready to run again
+#define CO_WAIT 1     // suspended at a CO_AWAIT_, parked until the I/O completes
+#define CO_DONE 2     // finished, the executor frees it
+
+typedef struct Coroutine Coroutine;
+
+// A coroutine body, returns one of the CO_ constants through the CO_ macros
+typedef int (*CoroutineBody)(Coroutine *co, void *arg);
+
+typedef struct CoroutineExecutor
+{
+    Queue levels[COROUTINE_LEVELS]; // ready coroutines by level, FIFO queues of Coroutine *
+    int epollFd;                    // parks coroutines awaiting I/O
+    unsigned long waiting;          // number of parked coroutines
+    unsigned long live;             // number of coroutines not done
+} CoroutineExecutor;
+
+struct Coroutine
+{
+    CoroutineBody body;         // resumed once per step
+    void *arg;                  // passed to 'body'
+    CoroutineExecutor *executor;
+    int resumePoint;            // where 'body' continues, 0 at the start
+    unsigned int level;         // 1 highest, 2, 3 lowest
+    unsigned int quantum;       // steps left in the current slice
+    unsigned int promoteFactor; // awaits left before a promotion
+    unsigned int demoteFactor;  // exhausted quanta left before a demotion
+    int waitFd;                 // file descriptor awaited, -1 if none
+    int timerFd;                // timerfd used by CO_AWAIT_SLEEP, -1 until the first sleep
+    unsigned int events;        // epoll events the last await completed with
+};
+
+#define CO_BEGIN(co) switch ((co)->resumePoint) { case 0:
+
+#define CO_YIELD(co)                  \
+    do                                \
+    {                                 \
+        (co)->resumePoint = __LINE__; \
+        return CO_CONTINUE;           \
+    case __LINE__:;                   \
+    } while (0)
+
+// suspends until 'fd' reports one of the epoll 'events'
+#define CO_AWAIT_FD(co, fd, events)              \
+    do                                           \
+    {                                            \
+        if (await_fd((co), (fd), (events)) != 0) \
+            return CO_DONE;                      \
+        (co)->resumePoint = __LINE__;            \
+        return CO_WAIT;                          \
+    case __LINE__:;                              \
+    } while (0)
+
+// suspends for 'milliseconds', a simulated I/O operation
+#define CO_AWAIT_SLEEP(co, milliseconds)            \
+    do                                              \
+    {                                               \
+        if (await_sleep((co), (milliseconds)) != 0) \
+            return CO_DONE;                         \
+        (co)->resumePoint = __LINE__;               \
+        return CO_WAIT;                             \
+    case __LINE__:;                                 \
+    } while (0)
+
+#define CO_END(co) } return CO_DONE
+
+/* initializes an empty executor
+*/
+void init_coroutine_executor(CoroutineExecutor *e);
+
+/* creates a coroutine running 'body' with 'arg', ready at level 1.
+   May be called from a coroutine body.
+*/
+Coroutine *spawn_coroutine(CoroutineExecutor *e, CoroutineBody body, void *arg);
+
+/* runs the coroutines until every one is done, waiting in epoll_wait()
+   while all of them are parked
+*/
+void run_coroutine_executor(CoroutineExecutor *e);
+
+/* frees the executor, which must not have live coroutines
+*/
+void destroy_coroutine_executor(CoroutineExecutor *e);
+
+/* used by the CO_AWAIT_ macros: parks 'co' on 'fd' or on its timer.
+   On failure they print the reason and the coroutine ends.
+*/
+int await_fd(Coroutine *co, int fd, unsigned int events);
+int await_sleep(Coroutine *co, unsigned long milliseconds);
+
+#endif
@@ -0,0 +1,100 @@
+/* coroutine_test: checks that the coroutine executor applies the MLFQ
+   level rules: a coroutine that only yields is demoted after the
+   quanta of levels 1 and 2, and awaiting I/O with CO_AWAIT_SLEEP and
+   CO_AWAIT_FD promotes it back by the promote factors of its levels.
+
+   usage: coroutine_test
+
+   build: gcc -Wall coroutine_test.c coroutine.c mlfq.c prioque.c -lpthread -o coroutine_test
+
+   Prints every failed check and exits with status 1 if there was one,
+   otherwise prints "coroutine_test: OK".
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "coroutine.h"
+
+// yields to reach level 3 and run a few steps there
+#define YIELD_STEPS (LEVEL_1_QUANTUM + 2 * LEVEL_2_QUANTUM + 10)
+
+typedef struct TestState
+{
+    unsigned int steps;                     // yields done
+    unsigned int levels[YIELD_STEPS];       // level of each step
+    unsigned int afterSleep;                // level after the CO_AWAIT_SLEEP
+    unsigned int afterFirstFd;              // level after the first CO_AWAIT_FD
+    unsigned int afterSecondFd;             // level after the second one
+    int pipe[2];                            // always readable, so the awaits complete at once
+} TestState;
+
+static unsigned int failures = 0;
+
+static void check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static int yield_then_await(Coroutine *co, void *arg)
+{
+    TestState *s = arg;
+
+    CO_BEGIN(co);
+    for (s->steps = 0; s->steps < YIELD_STEPS; s->steps++)
+    {
+        s->levels[s->steps] = co->level;
+        CO_YIELD(co);
+    }
+    CO_AWAIT_SLEEP(co, 1);
+    s->afterSleep = co->level;
+    CO_AWAIT_FD(co, s->pipe[0], EPOLLIN);
+    s->afterFirstFd = co->level;
+    CO_AWAIT_FD(co, s->pipe[0], EPOLLIN);
+    s->afterSecondFd = co->level;
+    CO_END(co);
+}
+
+int main(void)
+{
+    CoroutineExecutor e;
+    TestState s = {0};
+
+    if (pipe(s.pipe) != 0 || write(s.pipe[1], "x", 1) != 1)
+    {
+        perror("pipe() failed in function main()");
+        return 1;
+    }
+
+    init_coroutine_executor(&e);
+    spawn_coroutine(&e, yield_then_await, &s);
+    run_coroutine_executor(&e);
+    destroy_coroutine_executor(&e);
+
+    // level 1 demotes after one quantum, level 2 after two
+    check(s.levels[0] == 1, "a new coroutine starts at level 1");
+    check(s.levels[LEVEL_1_QUANTUM - 1] == 1, "level 1 runs a whole quantum");
+    check(s.levels[LEVEL_1_QUANTUM] == 2, "exhausting the level 1 quantum demotes to level 2");
+    check(s.levels[LEVEL_1_QUANTUM + 2 * LEVEL_2_QUANTUM - 1] == 2, "level 2 runs two quanta");
+    check(s.levels[LEVEL_1_QUANTUM + 2 * LEVEL_2_QUANTUM] == 3, "exhausting two level 2 quanta demotes to level 3");
+    check(s.levels[YIELD_STEPS - 1] == 3, "level 3 is the lowest level");
+
+    // level 3 promotes after one await, level 2 after two
+    check(s.afterSleep == 2, "CO_AWAIT_SLEEP on level 3 promotes to level 2");
+    check(s.afterFirstFd == 2, "one CO_AWAIT_FD on level 2 does not promote yet");
+    check(s.afterSecondFd == 1, "a second CO_AWAIT_FD on level 2 promotes to level 1");
+
+    close(s.pipe[0]);
+    close(s.pipe[1]);
+
+    if (failures > 0)
+    {
+        printf("coroutine_test: %u checks failed\n", failures);
+        return 1;
+    }
+    printf("coroutine_test: OK\n");
+    return 0;
+}
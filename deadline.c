@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "prioque.h"
+#include "deadline.h"
+
+static int earlier(const DeadlineEntry *a, const DeadlineEntry *b)
+{
+    return a->deadline < b->deadline || (a->deadline == b->deadline && a->sequence < b->sequence);
+}
+
+void init_deadline_queue(DeadlineQueue *q)
+{
+    memset(q, 0, sizeof(DeadlineQueue));
+}
+
+void destroy_deadline_queue(DeadlineQueue *q)
+{
+    free(q->heap);
+    init_deadline_queue(q);
+}
+
+void add_to_deadline_queue(DeadlineQueue *q, const Process *p)
+{
+    DeadlineEntry entry;
+    unsigned long i, parent;
+
+    if (q->length == q->capacity)
+    {
+        q->capacity = q->capacity ? 2 * q->capacity : 64;
+        q->heap = realloc(q->heap, q->capacity * sizeof(DeadlineEntry));
+        if (q->heap == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function add_to_deadline_queue()\n");
+            exit(1);
+        }
+    }
+
+    entry.deadline = p->deadline;
+    entry.sequence = q->sequence++;
+    entry.process = *p;
+
+    // sift up: move parents with later deadlines down into the hole
+    for (i = q->length++; i > 0; i = parent)
+    {
+        parent = (i - 1) / 2;
+        if (!earlier(&entry, &(q->heap[parent])))
+            break;
+        q->heap[i] = q->heap[parent];
+    }
+    q->heap[i] = entry;
+    if (q->length > q->peakLength)
+        q->peakLength = q->length;
+}
+
+const Process *peek_earliest_deadline(const DeadlineQueue *q)
+{
+    return q->length ? &(q->heap[0].process) : NULL;
+}
+
+int remove_earliest_deadline(DeadlineQueue *q, Process *p)
+{
+    DeadlineEntry last;
+    unsigned long i, child;
+
+    if (q->length == 0)
+        return FALSE;
+
+    *p = q->heap[0].process;
+    last = q->heap[--q->length];
+
+    // sift down: move the earlier child up into the hole until 'last' fits
+    for (i = 0; (child = 2 * i + 1) < q->length; i = child)
+    {
+        if (child + 1 < q->length && earlier(&(q->heap[child + 1]), &(q->heap[child])))
+            child++;
+        if (!earlier(&(q->heap[child]), &last))
+            break;
+        q->heap[i] = q->heap[child];
+    }
+    q->heap[i] = last;
+    return TRUE;
+}
+
+unsigned long deadline_queue_length(const DeadlineQueue *q)
+{
+    return q->length;
+}
+
+void deadline_queue_memory(const DeadlineQueue *q, Queue_memory *m)
+{
+    m->nodes = q->length;
+    m->peak_nodes = q->peakLength;
+    m->bytes = q->capacity * sizeof(DeadlineEntry);
+    m->peak_bytes = m->bytes;
+}
@@ -0,0 +1,60 @@
+#if !defined(DEADLINE_TYPE_DEFINED)
+#define DEADLINE_TYPE_DEFINED
+
+#include "prioque.h"
+#include "process.h"
+
+// An entry of a DeadlineQueue
+typedef struct DeadlineEntry
+{
+    unsigned long deadline; // absolute deadline the entry is ordered by
+    unsigned long sequence; // insertion order, breaks ties between equal deadlines
+    Process process;
+} DeadlineEntry;
+
+/* Binary min-heap of processes ordered by absolute deadline, earliest
+   first, for earliest deadline first scheduling.  Processes with equal
+   deadlines leave in the order they were added.  Adding and removing
+   take O(log n).
+*/
+typedef struct DeadlineQueue
+{
+    DeadlineEntry *heap;      // heap[0] has the earliest deadline
+    unsigned long length;     // number of processes
+    unsigned long capacity;   // number of entries 'heap' has room for
+    unsigned long sequence;   // sequence number of the next process added
+    unsigned long peakLength; // most processes queued at once
+} DeadlineQueue;
+
+/* initializes an empty queue
+*/
+void init_deadline_queue(DeadlineQueue *q);
+
+/* frees the heap of 'q'
+*/
+void destroy_deadline_queue(DeadlineQueue *q);
+
+/* adds a copy of process 'p', ordered by p->deadline
+*/
+void add_to_deadline_queue(DeadlineQueue *q, const Process *p);
+
+/* returns the process with the earliest deadline without removing it,
+   NULL if the queue is empty
+*/
+const Process *peek_earliest_deadline(const DeadlineQueue *q);
+
+/* removes the process with the earliest deadline into 'p'.  Returns
+   TRUE, or FALSE if the queue is empty
+*/
+int remove_earliest_deadline(DeadlineQueue *q, Process *p);
+
+/* returns the number of processes in 'q'
+*/
+unsigned long deadline_queue_length(const DeadlineQueue *q);
+
+/* stores the memory held by 'q' in 'm', one node per process.  The
+   heap is sized for the peak and never shrinks.
+*/
+void deadline_queue_memory(const DeadlineQueue *q, Queue_memory *m);
+
+#endif
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include "event.h"
+
+static FILE *timeline = NULL; // Chrome trace-event JSON output, if any
+static int timelineEvents = 0;
+
+#define TIMELINE_CPU 1 // trace-event pid of the CPU track
+#define TIMELINE_IO 2  // trace-event pid of the IO tracks, one thread per process
+
+int snprint_event(char *line, size_t size, const SchedulerEvent *e)
+{
+    switch (e->type)
+    {
+    case EVENT_CREATE:
+        return snprintf(line, size, "CREATE: Process %d entered the ready queue at time %d\n", e->PID, e->time);
+    case EVENT_RUN:
+        return snprintf(line, size, "RUN: Process %d started execution from level %d at time %d; wants to execute for %lu ticks.\n", e->PID, e->level, e->time, e->ticks);
+    case EVENT_QUEUED:
+        return snprintf(line, size, "QUEUED: Process %d queued at level %d at time %d.\n", e->PID, e->level, e->time);
+    case EVENT_IO:
+        return snprintf(line, size, "I/O: Process %d blocked for I/O at time %d.\n", e->PID, e->time);
+    case EVENT_FINISHED:
+        return snprintf(line, size, "FINISHED: Process %d finished at time %d.\n", e->PID, e->time);
+    }
+    return 0;
+}
+
+void format_event(FILE *out, const SchedulerEvent *e)
+{
+    char line[EVENT_LINE_MAX];
+
+    if (snprint_event(line, sizeof(line), e) > 0)
+        fputs(line, out);
+}
+
+// Starts the next entry of the traceEvents array
+static void begin_timeline_entry(void)
+{
+    fputs(timelineEvents++ ? ",\n" : "\n", timeline);
+}
+
+/* One tick is one trace microsecond.  A run starts at its RUN event and
+   ends at the event taking the process off the CPU, both stamped at the
+   start of a tick.  IO is done at the end of the tick its last unit is
+   counted in, hence the +1 for EVENT_IO_DONE.
+*/
+static void format_timeline_event(const SchedulerEvent *e)
+{
+    switch (e->type)
+    {
+    case EVENT_CREATE:
+        begin_timeline_entry();
+        fprintf(timeline, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"P%u I/O\"}}", TIMELINE_IO, e->PID, e->PID);
+        break;
+    case EVENT_RUN:
+        begin_timeline_entry();
+        fprintf(timeline, "{\"name\":\"P%u\",\"cat\":\"run\",\"ph\":\"B\",\"ts\":%d,\"pid\":%d,\"tid\":0,\"args\":{\"level\":%u,\"wants\":%lu}}", e->PID, e->time, TIMELINE_CPU, e->level, e->ticks);
+        break;
+    case EVENT_QUEUED:
+    case EVENT_FINISHED:
+    case EVENT_IO:
+        begin_timeline_entry();
+        fprintf(timeline, "{\"ph\":\"E\",\"ts\":%d,\"pid\":%d,\"tid\":0}", e->time, TIMELINE_CPU);
+        if (e->type == EVENT_IO)
+        {
+            begin_timeline_entry();
+            fprintf(timeline, "{\"name\":\"I/O\",\"cat\":\"io\",\"ph\":\"B\",\"ts\":%d,\"pid\":%d,\"tid\":%u}", e->time, TIMELINE_IO, e->PID);
+        }
+        break;
+    case EVENT_IO_DONE:
+        begin_timeline_entry();
+        fprintf(timeline, "{\"ph\":\"E\",\"ts\":%d,\"pid\":%d,\"tid\":%u}", e->time + 1, TIMELINE_IO, e->PID);
+        break;
+    case EVENT_PROMOTE:
+    case EVENT_DEMOTE:
+    case EVENT_PREEMPT:
+        begin_timeline_entry();
+        fprintf(timeline, "{\"name\":\"%s P%u\",\"cat\":\"sched\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%d,\"pid\":%d,\"tid\":0,\"args\":{\"level\":%u}}",
+                e->type == EVENT_PROMOTE ? "promote" : e->type == EVENT_DEMOTE ? "demote" : "preempt", e->PID, e->time, TIMELINE_CPU, e->level);
+        break;
+    case EVENT_DEADLINE_MISS:
+        begin_timeline_entry();
+        fprintf(timeline, "{\"name\":\"deadline miss P%u\",\"cat\":\"rt\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%d,\"pid\":%d,\"tid\":0,\"args\":{\"late\":%lu}}",
+                e->PID, e->time, TIMELINE_CPU, e->ticks);
+        break;
+    }
+}
+
+void write_event(const SchedulerEvent *e)
+{
+    format_event(stdout, e);
+    if (timeline != NULL)
+        format_timeline_event(e);
+}
+
+int open_timeline(const char *path)
+{
+    timeline = fopen(path, "w");
+    if (timeline == NULL)
+        return -1;
+
+    timelineEvents = 0;
+    fputs("{\"traceEvents\":[", timeline);
+    begin_timeline_entry();
+    fprintf(timeline, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"CPU\"}}", TIMELINE_CPU);
+    begin_timeline_entry();
+    fprintf(timeline, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"CPU 0\"}}", TIMELINE_CPU);
+    begin_timeline_entry();
+    fprintf(timeline, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"I/O\"}}", TIMELINE_IO);
+    return 0;
+}
+
+int timeline_open(void)
+{
+    return timeline != NULL;
+}
+
+void close_timeline(void)
+{
+    if (timeline == NULL)
+        return;
+
+    fputs("\n]}\n", timeline);
+    fclose(timeline);
+    timeline = NULL;
+}
@@ -0,0 +1,61 @@
+#if !defined(EVENT_TYPE_DEFINED)
+#define EVENT_TYPE_DEFINED
+
+#include <stdio.h>
+
+#define EVENT_CREATE 0   // process entered the ready queue
+#define EVENT_RUN 1      // process started execution
+#define EVENT_QUEUED 2   // process went back to a level queue
+#define EVENT_IO 3       // process blocked for IO
+#define EVENT_FINISHED 4 // process finished
+// the events below have no report line, they only appear on the timeline
+#define EVENT_IO_DONE 5  // process finished its IO burst
+#define EVENT_PROMOTE 6  // process moved up to 'level'
+#define EVENT_DEMOTE 7   // process moved down to 'level'
+#define EVENT_PREEMPT 8  // running process was preempted by a higher level one
+#define EVENT_DEADLINE_MISS 9 // real-time process finished a CPU burst after its deadline
+
+// Struct of a scheduling event, enough to format its report line
+typedef struct SchedulerEvent
+{
+    int type;            // one of the EVENT_ constants
+    unsigned int PID;    // PID of the process
+    unsigned int level;  // level of the process when the event happened
+    int time;            // CPUclock when the event happened
+    unsigned long ticks; // CPU time the process wants, for EVENT_RUN; in multi-CPU mode the CPU time it used, for EVENT_FINISHED;
+                         // ticks late, for EVENT_DEADLINE_MISS
+} SchedulerEvent;
+
+#define EVENT_LINE_MAX 128 // room for any report line
+
+/* formats the report line of event 'e' into 'line' like snprintf().
+   Returns its length, 0 for events without a report line.
+*/
+int snprint_event(char *line, size_t size, const SchedulerEvent *e);
+
+/* writes the report line of event 'e' to 'out'
+*/
+void format_event(FILE *out, const SchedulerEvent *e);
+
+/* writes event 'e' to every event output: its report line to stdout
+   and, if one is open, its entry to the timeline
+*/
+void write_event(const SchedulerEvent *e);
+
+/* starts streaming the schedule to 'path' as Chrome trace-event JSON,
+   which chrome://tracing and Perfetto open.  The CPU is one track, the
+   IO of every process another, runs and IO bursts are slices and
+   promotions, demotions and preemptions are instant events.  Returns
+   0 on success, -1 if 'path' cannot be created.
+*/
+int open_timeline(const char *path);
+
+/* returns nonzero if a timeline is open
+*/
+int timeline_open(void);
+
+/* completes and closes the timeline, after the last write_event()
+*/
+void close_timeline(void);
+
+#endif
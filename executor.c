@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "executor.h"
+#include "mlfq.h"
+
+// gives 't' the quantum and factors of 'level' from the level tables in mlfq.c
+static void enter_level(Task *t, unsigned int level)
+{
+    t->level = level;
+    t->quantum = levelQuantum[level - 1];
+    t->promoteFactor = levelPromoteFactor[level - 1];
+    t->demoteFactor = levelDemoteFactor[level - 1];
+}
+
+// Appends 't' to the queue of its level and wakes a worker if one sleeps
+static void make_ready(Executor *e, Task *t)
+{
+    Queue *q = e->policy == EXECUTOR_FIFO ? &(e->levels[0]) : &(e->levels[t->level - 1]);
+
+    __atomic_store_n(&(t->state), TASK_READY, __ATOMIC_RELAXED);
+    add_to_queue(q, &t, 0);
+
+    // pairs with the sleepers/ready check in take_task(): either this
+    // thread sees the sleeper or the sleeper sees the task
+    __atomic_add_fetch(&(e->ready), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(e->sleepers), __ATOMIC_SEQ_CST) > 0)
+    {
+        pthread_mutex_lock(&(e->lock));
+        pthread_cond_signal(&(e->work));
+        pthread_mutex_unlock(&(e->lock));
+    }
+}
+
+// Removes the first task of the highest non-empty level, NULL if all levels are empty
+static Task *remove_ready_task(Executor *e)
+{
+    Task *t;
+    unsigned int i;
+
+    for (i = 0; i < EXECUTOR_LEVELS; i++)
+    {
+        if (remove_from_front(&(e->levels[i]), &t) != NULL)
+        {
+            __atomic_sub_fetch(&(e->ready), 1, __ATOMIC_SEQ_CST);
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// Waits for a ready task, returns NULL once the executor stops
+static Task *take_task(Executor *e)
+{
+    Task *t;
+
+    for (;;)
+    {
+        t = remove_ready_task(e);
+        if (t != NULL)
+            return t;
+
+        pthread_mutex_lock(&(e->lock));
+        __atomic_add_fetch(&(e->sleepers), 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&(e->ready), __ATOMIC_SEQ_CST) == 0 && !e->stopping)
+            pthread_cond_wait(&(e->work), &(e->lock));
+        __atomic_sub_fetch(&(e->sleepers), 1, __ATOMIC_SEQ_CST);
+        if (e->stopping)
+        {
+            pthread_mutex_unlock(&(e->lock));
+            return NULL;
+        }
+        pthread_mutex_unlock(&(e->lock));
+    }
+}
+
+static void finish_task(Executor *e, Task *t)
+{
+    free(t);
+    if (__atomic_sub_fetch(&(e->outstanding), 1, __ATOMIC_SEQ_CST) == 0)
+    {
+        pthread_mutex_lock(&(e->lock));
+        pthread_cond_broadcast(&(e->idle));
+        pthread_mutex_unlock(&(e->lock));
+    }
+}
+
+// Parks a task that returned STEP_BLOCK, unless it was woken while it ran
+static void block_task(Executor *e, Task *t)
+{
+    int running = TASK_RUNNING;
+
+    if (e->policy == EXECUTOR_MLFQ)
+    {
+        // blocking before the quantum ran out, like IO in the simulator
+        if (t->level > 1)
+        {
+            if (--t->promoteFactor == 0)
+                enter_level(t, t->level - 1);
+        }
+        else
+            t->quantum = levelQuantum[0];
+    }
+
+    if (!__atomic_compare_exchange_n(&(t->state), &running, TASK_BLOCKED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        make_ready(e, t); // state was TASK_WOKEN
+}
+
+// Returns nonzero if a task of a level above 'level' is ready
+static int higher_level_waiting(Executor *e, unsigned int level)
+{
+    unsigned int i;
+
+    // the counter spares the queue locks while nothing is ready
+    if (__atomic_load_n(&(e->ready), __ATOMIC_RELAXED) == 0)
+        return 0;
+    for (i = 0; i + 1 < level; i++)
+    {
+        if (!empty_queue(&(e->levels[i])))
+            return 1;
+    }
+    return 0;
+}
+
+/* Runs 't' until it finishes, blocks, exhausts its quantum or a higher
+   level task is waiting at one of its yield points.
+*/
+static void run_task(Executor *e, Task *t)
+{
+    int step;
+
+    __atomic_store_n(&(t->state), TASK_RUNNING, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        step = t->function(t, t->arg);
+        if (step == STEP_DONE)
+        {
+            finish_task(e, t);
+            return;
+        }
+        if (step == STEP_BLOCK)
+        {
+            block_task(e, t);
+            return;
+        }
+        if (e->policy == EXECUTOR_FIFO)
+            continue;
+
+        if (--t->quantum == 0)
+        {
+            if (t->level < EXECUTOR_LEVELS)
+            {
+                if (--t->demoteFactor == 0)
+                    enter_level(t, t->level + 1);
+                else
+                    t->quantum = levelQuantum[t->level - 1];
+            }
+            else
+                t->quantum = levelQuantum[EXECUTOR_LEVELS - 1];
+            make_ready(e, t);
+            return;
+        }
+
+        // preempted tasks keep the rest of their quantum
+        if (t->level > 1 && higher_level_waiting(e, t->level))
+        {
+            make_ready(e, t);
+            return;
+        }
+    }
+}
+
+static void *work(void *arg)
+{
+    Executor *e = (Executor *)arg;
+    Task *t;
+
+    while ((t = take_task(e)) != NULL)
+        run_task(e, t);
+    return NULL;
+}
+
+void init_executor(Executor *e, unsigned int workers, int policy)
+{
+    unsigned int i;
+
+    e->policy = policy;
+    for (i = 0; i < EXECUTOR_LEVELS; i++)
+        init_two_lock_queue(&(e->levels[i]), sizeof(Task *));
+    e->ready = 0;
+    e->outstanding = 0;
+    e->sleepers = 0;
+    e->stopping = 0;
+    pthread_mutex_init(&(e->lock), NULL);
+    pthread_cond_init(&(e->work), NULL);
+    pthread_cond_init(&(e->idle), NULL);
+
+    e->workerCount = workers;
+    e->workers = malloc(workers * sizeof(pthread_t));
+    if (e->workers == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function init_executor()\n");
+        exit(1);
+    }
+    for (i = 0; i < workers; i++)
+    {
+        if (pthread_create(&(e->workers[i]), NULL, work, e) != 0)
+        {
+            fprintf(stderr, "pthread_create() failed in function init_executor()\n");
+            exit(1);
+        }
+    }
+}
+
+Task *submit_task(Executor *e, TaskFunction function, void *arg)
+{
+    Task *t = malloc(sizeof(Task));
+
+    if (t == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function submit_task()\n");
+        exit(1);
+    }
+    t->function = function;
+    t->arg = arg;
+    t->executor = e;
+    enter_level(t, 1);
+
+    __atomic_add_fetch(&(e->outstanding), 1, __ATOMIC_SEQ_CST);
+    make_ready(e, t);
+    return t;
+}
+
+void wake_task(Task *t)
+{
+    int state = __atomic_load_n(&(t->state), __ATOMIC_ACQUIRE);
+
+    for (;;)
+    {
+        if (state == TASK_BLOCKED)
+        {
+            if (__atomic_compare_exchange_n(&(t->state), &state, TASK_READY, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                make_ready(t->executor, t);
+                return;
+            }
+        }
+        else if (state == TASK_RUNNING)
+        {
+            if (__atomic_compare_exchange_n(&(t->state), &state, TASK_WOKEN, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return;
+        }
+        else
+            return; // ready, or already woken
+    }
+}
+
+void wait_executor(Executor *e)
+{
+    pthread_mutex_lock(&(e->lock));
+    while (__atomic_load_n(&(e->outstanding), __ATOMIC_SEQ_CST) > 0)
+        pthread_cond_wait(&(e->idle), &(e->lock));
+    pthread_mutex_unlock(&(e->lock));
+}
+
+void destroy_executor(Executor *e)
+{
+    unsigned int i;
+
+    wait_executor(e);
+
+    pthread_mutex_lock(&(e->lock));
+    e->stopping = 1;
+    pthread_cond_broadcast(&(e->work));
+    pthread_mutex_unlock(&(e->lock));
+    for (i = 0; i < e->workerCount; i++)
+        pthread_join(e->workers[i], NULL);
+    free(e->workers);
+
+    for (i = 0; i < EXECUTOR_LEVELS; i++)
+        destroy_queue(&(e->levels[i]));
+    pthread_mutex_destroy(&(e->lock));
+    pthread_cond_destroy(&(e->work));
+    pthread_cond_destroy(&(e->idle));
+}
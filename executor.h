@@ -0,0 +1,97 @@
+#if !defined(EXECUTOR_TYPE_DEFINED)
+#define EXECUTOR_TYPE_DEFINED
+
+#include <pthread.h>
+#include "prioque.h"
+#include "mlfq.h"
+
+/* Embeddable MLFQ task executor: real tasks run on a pool of worker
+   threads under the policy the simulator models.  A task is a function
+   the executor calls repeatedly; every call is one step and the return
+   between two steps is the task's yield point.  A task starts at level
+   1 and runs up to the quantum of its level (10, 30 and 100 steps);
+   exhausting the quantum counts towards a demotion and blocking counts
+   towards a promotion.  The quanta and factors are the level tables
+   of mlfq.h, which the simulator uses too.  At every yield point a
+   task gives the worker up if a task of a higher level is waiting.
+
+   Each level is a two-lock prioque queue, so submitting and waking
+   tasks never contends with workers taking tasks.
+*/
+
+#define EXECUTOR_LEVELS MLFQ_LEVELS
+
+#define EXECUTOR_MLFQ 0 // multi-level feedback queue policy
+#define EXECUTOR_FIFO 1 // one FIFO queue, tasks run until they block or finish
+
+// Return values of a task step
+#define STEP_CONTINUE 0 // the task has more work
+#define STEP_BLOCK 1    // the task waits until wake_task() is called on it
+#define STEP_DONE 2     // the task finished, the executor frees it
+
+// States of a task
+#define TASK_READY 0   // in a level queue
+#define TASK_RUNNING 1 // taken by a worker
+#define TASK_WOKEN 2   // running, but wake_task() arrived before it blocked
+#define TASK_BLOCKED 3 // waiting for wake_task()
+
+typedef struct Executor Executor;
+typedef struct Task Task;
+
+// One step of a task, returns one of the STEP_ constants
+typedef int (*TaskFunction)(Task *task, void *arg);
+
+// Struct of a task, only the executor writes it
+struct Task
+{
+    TaskFunction function;      // called once per step
+    void *arg;                  // passed to 'function'
+    Executor *executor;         // executor the task was submitted to
+    unsigned int level;         // 1 highest, 2, 3 lowest
+    unsigned int quantum;       // steps left in the current slice
+    unsigned int promoteFactor; // blocks left before a promotion
+    unsigned int demoteFactor;  // exhausted quanta left before a demotion
+    int state;                  // one of the TASK_ constants, changed atomically
+};
+
+struct Executor
+{
+    int policy;                       // EXECUTOR_MLFQ or EXECUTOR_FIFO
+    Queue levels[EXECUTOR_LEVELS];    // ready tasks by level, two-lock queues of Task *
+    pthread_t *workers;
+    unsigned int workerCount;
+    unsigned long ready;              // tasks in the level queues, changed atomically
+    unsigned long outstanding;        // tasks submitted and not finished, changed atomically
+    unsigned int sleepers;            // workers waiting for tasks, changed atomically
+    int stopping;                     // set by destroy_executor()
+    pthread_mutex_t lock;             // protects the waits below
+    pthread_cond_t work;              // signalled when a task becomes ready
+    pthread_cond_t idle;              // signalled when the last outstanding task finished
+};
+
+/* starts 'workers' worker threads scheduling tasks with 'policy'
+*/
+void init_executor(Executor *e, unsigned int workers, int policy);
+
+/* submits a task calling 'function' with 'arg' until it returns
+   STEP_DONE.  The returned task is valid until then; it may be passed
+   to wake_task() by any thread.
+*/
+Task *submit_task(Executor *e, TaskFunction function, void *arg);
+
+/* makes a task that returned STEP_BLOCK ready again.  A wake that
+   arrives while the task is still running is remembered, so the task
+   is made ready as soon as it blocks.  Waking a ready task does nothing.
+*/
+void wake_task(Task *t);
+
+/* waits until every submitted task finished
+*/
+void wait_executor(Executor *e);
+
+/* waits until every submitted task finished, then stops the workers
+   and frees the executor's resources
+*/
+void destroy_executor(Executor *e);
+
+#endif
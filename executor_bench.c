@@ -0,0 +1,422 @@
+/* executor_bench: compares the MLFQ executor with a plain FIFO pool
+   (the same executor with EXECUTOR_FIFO) on a mix of short and long
+   CPU bound tasks submitted in one burst, and on the same mix with
+   tasks that block and are woken by a separate thread.
+
+   usage: executor_bench [-w workers] [-n tasks] [-l long_percent]
+
+   For each policy it prints the throughput and the submit-to-finish
+   latency percentiles of the short and the long tasks.
+
+   usage: executor_bench -q [-w threads] [-n elements]
+
+   benchmarks the prioque queues the executor is built on instead:
+   'threads' producers and as many consumers pass 'elements' elements
+   each through one FIFO queue, once with the single reader-writer
+   lock and once with the two-lock (head/tail) mode.  A single thread
+   then adds, walks and removes 'elements' elements with the elements
+   stored inline in the queue nodes, and again with each element in an
+   allocation of its own that the node points to, the layout prioque
+   used before.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include "executor.h"
+
+#define SHORT_STEPS 5    // steps of a short task
+#define LONG_STEPS 2000  // steps of a long task
+#define STEP_WORK 2000   // iterations of busy work per step
+#define BLOCK_EVERY 4    // blocking tasks block every BLOCK_EVERY steps
+#define QUEUE_ELEMENTS 1000000 // default elements per producer in the queue benchmarks
+
+typedef struct BenchTask
+{
+    unsigned int steps;       // steps left
+    unsigned int done;        // steps executed
+    int isLong;               // long or short task
+    int blocks;               // block every BLOCK_EVERY steps
+    unsigned long submitted;  // ns
+    unsigned long finished;   // ns
+} BenchTask;
+
+// A 64 byte queue element, about the size of a Process
+typedef struct QueueItem
+{
+    unsigned long sequence;
+    char payload[56];
+} QueueItem;
+
+// One producer or consumer of the queue benchmarks
+typedef struct QueueWorker
+{
+    pthread_t thread;
+    Queue *q;
+    unsigned long count;      // elements a producer adds
+    unsigned long *remaining; // elements the consumers still have to take
+    unsigned long checksum;   // sum of the sequence numbers a consumer took
+} QueueWorker;
+
+static unsigned long sink; // keeps the busy work from being optimized away
+
+// blocked tasks, woken by the waker thread
+static Task **parked;
+static unsigned long parkedCount, parkedCapacity;
+static pthread_mutex_t parkedLock = PTHREAD_MUTEX_INITIALIZER;
+static int stopWaker;
+
+static unsigned long now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static int bench_step(Task *task, void *arg)
+{
+    BenchTask *b = (BenchTask *)arg;
+    unsigned long i, x = 0;
+
+    for (i = 0; i < STEP_WORK; i++)
+    {
+        x += i * i;
+        __asm__ volatile("" : "+r"(x));
+    }
+    __atomic_store_n(&sink, x, __ATOMIC_RELAXED);
+
+    b->done++;
+    if (--b->steps == 0)
+    {
+        b->finished = now();
+        return STEP_DONE;
+    }
+    if (b->blocks && b->done % BLOCK_EVERY == 0)
+    {
+        pthread_mutex_lock(&parkedLock);
+        if (parkedCount == parkedCapacity)
+        {
+            parkedCapacity = parkedCapacity ? 2 * parkedCapacity : 1024;
+            parked = realloc(parked, parkedCapacity * sizeof(Task *));
+            if (parked == NULL)
+            {
+                fprintf(stderr, "realloc() failed in function bench_step()\n");
+                exit(1);
+            }
+        }
+        parked[parkedCount++] = task;
+        pthread_mutex_unlock(&parkedLock);
+        return STEP_BLOCK;
+    }
+    return STEP_CONTINUE;
+}
+
+// Wakes every parked task, modelling IO that completes shortly after it started
+static void *wake_parked(void *arg)
+{
+    Task **batch = NULL;
+    unsigned long count, capacity = 0, i;
+
+    (void)arg; // the thread takes no argument
+    while (!__atomic_load_n(&stopWaker, __ATOMIC_ACQUIRE))
+    {
+        pthread_mutex_lock(&parkedLock);
+        count = parkedCount;
+        if (count > capacity)
+        {
+            capacity = parkedCapacity;
+            batch = realloc(batch, capacity * sizeof(Task *));
+            if (batch == NULL)
+            {
+                fprintf(stderr, "realloc() failed in function wake_parked()\n");
+                exit(1);
+            }
+        }
+        memcpy(batch, parked, count * sizeof(Task *));
+        parkedCount = 0;
+        pthread_mutex_unlock(&parkedLock);
+
+        for (i = 0; i < count; i++)
+            wake_task(batch[i]);
+        sched_yield();
+    }
+    free(batch);
+    return NULL;
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void print_latencies(const char *kind, BenchTask *tasks, unsigned long count, int isLong)
+{
+    unsigned long *latency = malloc(count * sizeof(unsigned long));
+    unsigned long i, n = 0;
+
+    if (latency == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function print_latencies()\n");
+        exit(1);
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (tasks[i].isLong == isLong)
+            latency[n++] = tasks[i].finished - tasks[i].submitted;
+    }
+    if (n > 0)
+    {
+        qsort(latency, n, sizeof(unsigned long), compare_latency);
+        printf("  %-5s %7lu tasks  p50 %9.3f ms  p99 %9.3f ms  max %9.3f ms\n", kind, n, latency[n / 2] / 1e6,
+               latency[n * 99 / 100] / 1e6, latency[n - 1] / 1e6);
+    }
+    free(latency);
+}
+
+static void run(const char *name, int policy, int blocking, unsigned int workers, unsigned long count, int longPercent)
+{
+    Executor e;
+    BenchTask *tasks = calloc(count, sizeof(BenchTask));
+    pthread_t waker;
+    unsigned long start, elapsed, i;
+
+    if (tasks == NULL)
+    {
+        fprintf(stderr, "calloc() failed in function run()\n");
+        exit(1);
+    }
+    // a fixed pattern, so both policies run the same tasks
+    for (i = 0; i < count; i++)
+    {
+        tasks[i].isLong = (i * 7919) % 100 < (unsigned long)longPercent;
+        tasks[i].steps = tasks[i].isLong ? LONG_STEPS : SHORT_STEPS;
+        tasks[i].blocks = blocking;
+    }
+
+    stopWaker = 0;
+    if (blocking)
+        pthread_create(&waker, NULL, wake_parked, NULL);
+    init_executor(&e, workers, policy);
+
+    start = now();
+    for (i = 0; i < count; i++)
+    {
+        tasks[i].submitted = now();
+        submit_task(&e, bench_step, &tasks[i]);
+    }
+    wait_executor(&e);
+    elapsed = now() - start;
+
+    destroy_executor(&e);
+    if (blocking)
+    {
+        __atomic_store_n(&stopWaker, 1, __ATOMIC_RELEASE);
+        pthread_join(waker, NULL);
+    }
+
+    printf("%s: %.0f tasks/s (%.3f s)\n", name, count / (elapsed / 1e9), elapsed / 1e9);
+    print_latencies("short", tasks, count, 0);
+    print_latencies("long", tasks, count, 1);
+    free(tasks);
+}
+
+static void *produce_items(void *arg)
+{
+    QueueWorker *w = (QueueWorker *)arg;
+    QueueItem item;
+    unsigned long i;
+
+    memset(&item, 0, sizeof(item));
+    for (i = 0; i < w->count; i++)
+    {
+        item.sequence = i;
+        add_to_queue(w->q, &item, 0);
+    }
+    return NULL;
+}
+
+static void *consume_items(void *arg)
+{
+    QueueWorker *w = (QueueWorker *)arg;
+    QueueItem item;
+
+    while (__atomic_load_n(w->remaining, __ATOMIC_RELAXED) > 0)
+    {
+        if (remove_from_front(w->q, &item) == NULL)
+        {
+            sched_yield();
+            continue;
+        }
+        w->checksum += item.sequence;
+        __atomic_fetch_sub(w->remaining, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Passes 'count' elements from each of 'threads' producers to as many consumers through one FIFO queue
+static void run_producer_consumer(const char *name, int twoLock, unsigned int threads, unsigned long count)
+{
+    Queue q;
+    QueueWorker *workers = calloc(2 * threads, sizeof(QueueWorker));
+    unsigned long remaining = threads * count, checksum = 0, start, elapsed, i;
+
+    if (workers == NULL)
+    {
+        fprintf(stderr, "calloc() failed in function run_producer_consumer()\n");
+        exit(1);
+    }
+    if (twoLock)
+        init_two_lock_queue(&q, sizeof(QueueItem));
+    else
+        init_queue(&q, sizeof(QueueItem), TRUE, NULL, TRUE);
+
+    start = now();
+    for (i = 0; i < 2 * threads; i++)
+    {
+        workers[i].q = &q;
+        workers[i].count = count;
+        workers[i].remaining = &remaining;
+        pthread_create(&workers[i].thread, NULL, i < threads ? produce_items : consume_items, &workers[i]);
+    }
+    for (i = 0; i < 2 * threads; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        checksum += workers[i].checksum;
+    }
+    elapsed = now() - start;
+
+    if (checksum != threads * (count * (count - 1) / 2))
+        fprintf(stderr, "%s: elements were lost or duplicated\n", name);
+    printf("%s: %.2f M elements/s (%.3f s)\n", name, threads * count / (elapsed / 1e3), elapsed / 1e9);
+    destroy_queue(&q);
+    free(workers);
+}
+
+// Adds, walks with a read cursor and removes 'count' elements, stored inline or behind a pointer
+static void run_node_storage(const char *name, int pointers, unsigned long count)
+{
+    Queue q;
+    Queue_cursor cursor;
+    QueueItem item, *stored;
+    unsigned long start, added, walked, removed, sum = 0, i;
+
+    init_queue(&q, pointers ? sizeof(QueueItem *) : sizeof(QueueItem), TRUE, NULL, TRUE);
+    memset(&item, 0, sizeof(item));
+
+    start = now();
+    for (i = 0; i < count; i++)
+    {
+        item.sequence = i;
+        if (pointers)
+        {
+            stored = malloc(sizeof(QueueItem));
+            if (stored == NULL)
+            {
+                fprintf(stderr, "malloc() failed in function run_node_storage()\n");
+                exit(1);
+            }
+            *stored = item;
+            add_to_queue(&q, &stored, 0);
+        }
+        else
+            add_to_queue(&q, &item, 0);
+    }
+    added = now();
+
+    for (open_cursor(&q, &cursor, FALSE); !cursor_at_end(&cursor); cursor_next(&cursor))
+    {
+        if (pointers)
+            sum += (*(QueueItem *const *)cursor_element(&cursor))->sequence;
+        else
+            sum += ((const QueueItem *)cursor_element(&cursor))->sequence;
+    }
+    close_cursor(&cursor);
+    walked = now();
+
+    for (i = 0; i < count; i++)
+    {
+        if (pointers)
+        {
+            remove_from_front(&q, &stored);
+            sum -= stored->sequence;
+            free(stored);
+        }
+        else
+        {
+            remove_from_front(&q, &item);
+            sum -= item.sequence;
+        }
+    }
+    removed = now();
+
+    if (sum != 0)
+        fprintf(stderr, "%s: elements were lost or duplicated\n", name);
+    printf("%s: add %6.1f ns, walk %6.1f ns, remove %6.1f ns per element\n", name, (double)(added - start) / count,
+           (double)(walked - added) / count, (double)(removed - walked) / count);
+    destroy_queue(&q);
+}
+
+static void run_queue_benchmarks(unsigned int threads, unsigned long count)
+{
+    printf("%u producers and %u consumers, %lu elements of %zu bytes each\n", threads, threads, count, sizeof(QueueItem));
+    run_producer_consumer("single lock FIFO", FALSE, threads, count);
+    run_producer_consumer("two-lock FIFO   ", TRUE, threads, count);
+    run_node_storage("inline elements ", FALSE, count);
+    run_node_storage("pointer elements", TRUE, count);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int workers = 4;
+    unsigned long count = 0;
+    int longPercent = 5, queues = FALSE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:n:l:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'q':
+            queues = TRUE;
+            break;
+        case 'w':
+            workers = atoi(optarg);
+            break;
+        case 'n':
+            count = atol(optarg);
+            break;
+        case 'l':
+            longPercent = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-w workers] [-n tasks] [-l long_percent]\n       %s -q [-w threads] [-n elements]\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0)
+        count = queues ? QUEUE_ELEMENTS : 20000;
+    if (workers == 0)
+    {
+        fprintf(stderr, "usage: %s [-w workers] [-n tasks] [-l long_percent]\n       %s -q [-w threads] [-n elements]\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (queues)
+    {
+        run_queue_benchmarks(workers, count);
+        return 0;
+    }
+
+    printf("%u workers, %lu tasks, %d%% long (%d steps) and short (%d steps)\n", workers, count, longPercent, LONG_STEPS,
+           SHORT_STEPS);
+    run("FIFO, CPU bound", EXECUTOR_FIFO, 0, workers, count, longPercent);
+    run("MLFQ, CPU bound", EXECUTOR_MLFQ, 0, workers, count, longPercent);
+    run("FIFO, blocking", EXECUTOR_FIFO, 1, workers, count, longPercent);
+    run("MLFQ, blocking", EXECUTOR_MLFQ, 1, workers, count, longPercent);
+    free(parked);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ingest.h"
+
+// first slot to probe for a PID, multiplicative hashing keeps runs of consecutive PIDs apart
+static unsigned long home_slot(const IngestTable *t, unsigned int pid)
+{
+    return ((unsigned long)pid * 2654435761UL) & (t->tableSize - 1);
+}
+
+static void *grow(void *buffer, unsigned long *capacity, size_t elementSize)
+{
+    *capacity = *capacity ? 2 * *capacity : 4;
+    buffer = realloc(buffer, *capacity * elementSize);
+    if (buffer == NULL)
+    {
+        fprintf(stderr, "realloc() failed in function ingest_behavior()\n");
+        exit(1);
+    }
+    return buffer;
+}
+
+// Makes room for twice as many behaviors in 'p', moving them to the heap when they were inline
+static void spill_behaviors(IngestedProcess *p)
+{
+    ProcessBehavior *behaviors;
+
+    behaviors = realloc(p->behaviors, 2 * p->capacity * sizeof(ProcessBehavior));
+    if (behaviors == NULL)
+    {
+        fprintf(stderr, "realloc() failed in function ingest_behavior()\n");
+        exit(1);
+    }
+    if (p->behaviors == NULL)
+        memcpy(behaviors, p->inlineBehaviors, p->count * sizeof(ProcessBehavior));
+    p->behaviors = behaviors;
+    p->capacity *= 2;
+}
+
+static void grow_slots(IngestTable *t)
+{
+    unsigned long i, slot;
+
+    free(t->slots);
+    t->tableSize = t->tableSize ? 2 * t->tableSize : 1024;
+    t->slots = calloc(t->tableSize, sizeof(unsigned long));
+    if (t->slots == NULL)
+    {
+        fprintf(stderr, "calloc() failed in function ingest_behavior()\n");
+        exit(1);
+    }
+
+    for (i = 0; i < t->count; i++)
+    {
+        slot = home_slot(t, t->processes[i].PID);
+        while (t->slots[slot] != 0)
+            slot = (slot + 1) & (t->tableSize - 1);
+        t->slots[slot] = i + 1;
+    }
+}
+
+int parse_trace_line(const char *line, TraceRecord *r)
+{
+    char key[16];
+    unsigned long value;
+    int used;
+
+    if (sscanf(line, "%u %u %lu %lu %u%n", &(r->arrival), &(r->PID), &(r->behavior.CPUBurst), &(r->behavior.IOBurst),
+               &(r->behavior.repeat), &used) != 5)
+        return 0;
+    r->deadline = 0;
+    r->period = 0;
+    r->workingSet = 0;
+
+    for (line += used; sscanf(line, " %15[^= \t\r\n]=%lu%n", key, &value, &used) == 2; line += used)
+    {
+        if (strcmp(key, "deadline") == 0)
+            r->deadline = value;
+        else if (strcmp(key, "period") == 0)
+            r->period = value;
+        else if (strcmp(key, "wss") == 0)
+            r->workingSet = value;
+        else
+            return 0;
+    }
+    return line[strspn(line, " \t\r\n")] == '\0';
+}
+
+int read_trace_record(FILE *in, TraceRecord *r)
+{
+    char line[TRACE_LINE_MAX];
+    int c;
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        // a line that filled the buffer without its newline continues past it, unless the
+        // file ends there: drop the rest of it instead of reading it as a line of its own
+        if (strchr(line, '\n') == NULL && (c = getc(in)) != EOF)
+        {
+            if (c != '\n')
+            {
+                while ((c = getc(in)) != EOF && c != '\n')
+                    ;
+                fprintf(stderr, "ignoring trace line longer than %d characters: %.40s...\n", TRACE_LINE_MAX - 1, line);
+                continue;
+            }
+        }
+        if (line[strspn(line, " \t\r\n")] == '\0')
+            continue;
+        if (parse_trace_line(line, r))
+            return 1;
+        fprintf(stderr, "ignoring malformed trace line: %s%s", line, strchr(line, '\n') ? "" : "\n");
+    }
+    return 0;
+}
+
+void init_ingest_table(IngestTable *t)
+{
+    memset(t, 0, sizeof(IngestTable));
+}
+
+IngestedProcess *ingest_behavior(IngestTable *t, unsigned int pid, unsigned int arrival, const ProcessBehavior *b)
+{
+    IngestedProcess *p;
+    unsigned long slot;
+
+    // keep the load factor at most 1/2
+    if (2 * (t->count + 1) > t->tableSize)
+        grow_slots(t);
+
+    slot = home_slot(t, pid);
+    while (t->slots[slot] != 0 && t->processes[t->slots[slot] - 1].PID != pid)
+        slot = (slot + 1) & (t->tableSize - 1);
+
+    if (t->slots[slot] == 0)
+    {
+        if (t->count == t->capacity)
+            t->processes = grow(t->processes, &(t->capacity), sizeof(IngestedProcess));
+        p = &(t->processes[t->count++]);
+        memset(p, 0, sizeof(IngestedProcess));
+        p->PID = pid;
+        p->capacity = INGEST_INLINE_BEHAVIORS;
+        t->slots[slot] = t->count;
+    }
+    else
+        p = &(t->processes[t->slots[slot] - 1]);
+
+    if (p->count == p->capacity)
+        spill_behaviors(p);
+    if (p->behaviors != NULL)
+        p->behaviors[p->count++] = *b;
+    else
+        p->inlineBehaviors[p->count++] = *b;
+    p->arrival_time = arrival;
+    return p;
+}
+
+IngestedProcess *ingest_record(IngestTable *t, const TraceRecord *r)
+{
+    IngestedProcess *p = ingest_behavior(t, r->PID, r->arrival, &(r->behavior));
+
+    if (r->deadline > 0)
+        p->deadline = r->deadline;
+    if (r->period > 0)
+        p->period = r->period;
+    if (r->workingSet > 0)
+        p->workingSet = r->workingSet;
+    return p;
+}
+
+const ProcessBehavior *ingested_behaviors(const IngestedProcess *p)
+{
+    return p->behaviors != NULL ? p->behaviors : p->inlineBehaviors;
+}
+
+void destroy_ingest_table(IngestTable *t)
+{
+    unsigned long i;
+
+    for (i = 0; i < t->count; i++)
+        free(t->processes[i].behaviors);
+    free(t->processes);
+    free(t->slots);
+    init_ingest_table(t);
+}
@@ -0,0 +1,98 @@
+#if !defined(INGEST_TYPE_DEFINED)
+#define INGEST_TYPE_DEFINED
+
+#include <stdio.h>
+#include "behavior.h"
+
+#define TRACE_LINE_MAX 256 // bytes of a trace line buffer, longer lines are rejected
+#define INGEST_INLINE_BEHAVIORS 3 // behaviors of a process kept inline before spilling to the heap
+
+/* One behavior line of a trace: arrival PID CPUBurst IOBurst repeat,
+   optionally followed by key=value fields:
+     deadline=D   the process is real-time, each of its CPU bursts must
+                  finish within D ticks of becoming ready
+     period=P     its CPU bursts become ready at most once every P ticks,
+                  D if not given
+     wss=W        working set size of the process, in the ticks it takes
+                  to reload it into a cold cache
+*/
+typedef struct TraceRecord
+{
+    unsigned int arrival;      // arrival time of the process
+    unsigned int PID;          // PID of the process
+    ProcessBehavior behavior;  // the behavior
+    unsigned long deadline;    // relative deadline, 0 if the line has none
+    unsigned long period;      // period, 0 if the line has none
+    unsigned long workingSet;  // working set size, 0 if the line has none
+} TraceRecord;
+
+/* A process being assembled from the behavior lines of a trace.
+
+   Most processes have one to three behavior lines, so the first
+   INGEST_INLINE_BEHAVIORS behaviors are stored in the process itself
+   and only longer processes allocate.  Processes move when the table
+   grows, so 'behaviors' never points into the process: use
+   ingested_behaviors() to get at them.
+*/
+typedef struct IngestedProcess
+{
+    unsigned int PID;             // PID of the process
+    unsigned int arrival_time;    // arrival time given by the latest line of the process
+    ProcessBehavior inlineBehaviors[INGEST_INLINE_BEHAVIORS]; // the behaviors while they fit
+    ProcessBehavior *behaviors;   // the behaviors once spilled to the heap, NULL before
+    unsigned long count;          // number of behaviors
+    unsigned long capacity;       // number of behaviors the process has room for
+    unsigned long deadline;       // relative deadline given by the latest line with one, 0 if none
+    unsigned long period;         // period given by the latest line with one, 0 if none
+    unsigned long workingSet;     // working set size given by the latest line with one, 0 if none
+} IngestedProcess;
+
+/* Groups behavior lines into processes by PID, whatever order the lines
+   come in.  An open addressing hash map from PID to the index of the
+   process in 'processes' makes every line O(1).
+*/
+typedef struct IngestTable
+{
+    IngestedProcess *processes;   // processes in the order their PID was first seen
+    unsigned long count;          // number of processes
+    unsigned long capacity;       // number of processes 'processes' has room for
+    unsigned long *slots;         // hash map, index + 1 of a process or 0 for an empty slot
+    unsigned long tableSize;      // number of slots, a power of 2
+} IngestTable;
+
+/* parses trace line 'line' into 'r'.  Returns 1 if it is a valid
+   behavior line, 0 otherwise
+*/
+int parse_trace_line(const char *line, TraceRecord *r);
+
+/* reads the next behavior line of a trace from 'in' into 'r'; blank
+   lines are skipped, malformed ones and lines too long for a
+   TRACE_LINE_MAX buffer are reported on stderr and skipped.
+   return 1 if a line was read, 0 at end of file
+*/
+int read_trace_record(FILE *in, TraceRecord *r);
+
+/* initializes an empty table
+*/
+void init_ingest_table(IngestTable *t);
+
+/* appends behavior 'b' to the process 'pid', creating the process if
+   its PID was not seen before, and sets its arrival time to 'arrival'.
+   Returns the process.
+*/
+IngestedProcess *ingest_behavior(IngestTable *t, unsigned int pid, unsigned int arrival, const ProcessBehavior *b);
+
+/* ingests the behavior of trace line 'r' like ingest_behavior() and
+   takes the real-time and working set fields the line gives.  Returns the process.
+*/
+IngestedProcess *ingest_record(IngestTable *t, const TraceRecord *r);
+
+/* returns the behaviors of 'p', in the order their lines were read
+*/
+const ProcessBehavior *ingested_behaviors(const IngestedProcess *p);
+
+/* frees everything held by the table, which is left empty
+*/
+void destroy_ingest_table(IngestTable *t);
+
+#endif
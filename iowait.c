@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "iowait.h"
+
+#if defined(__x86_64__) && !defined(IOWAIT_NO_SIMD)
+#include <immintrin.h>
+#define IOWAIT_SIMD
+#endif
+
+/* A countdown kernel does the IO of one tick on the 'length' counters
+   in 'IOTime': starting at position 'start', it decrements the counters
+   in queue order until it visited as many processes as are still
+   blocked.  The positions of counters reaching 0 are appended to
+   'done', whose first '*finished' entries are already filled.  Returns
+   the position where the tick stopped.
+*/
+typedef unsigned long (*CountdownKernel)(unsigned long *IOTime, unsigned long start, unsigned long length, unsigned int *done,
+                                         unsigned long *finished);
+
+static unsigned long countdown_scalar(unsigned long *IOTime, unsigned long start, unsigned long length, unsigned int *done,
+                                      unsigned long *finished)
+{
+    unsigned long i, f = *finished;
+
+    for (i = start; i < length - f; i++)
+    {
+        if (IOTime[i] == 1)
+            done[f++] = i;
+        IOTime[i]--;
+    }
+    *finished = f;
+    return i;
+}
+
+#if defined(IOWAIT_SIMD)
+/* The vector kernels only take a whole vector while the tick is sure to
+   visit every counter in it, even if all of its counters that are 1
+   finish; the scalar kernel does the last few counters.
+*/
+__attribute__((target("avx2,popcnt"))) static unsigned long countdown_avx2(unsigned long *IOTime, unsigned long start,
+                                                                         unsigned long length, unsigned int *done,
+                                                                         unsigned long *finished)
+{
+    const __m256i one = _mm256_set1_epi64x(1);
+    unsigned long i, f = *finished;
+    unsigned int mask;
+    __m256i v;
+
+    for (i = start; i + 4 <= length; i += 4)
+    {
+        v = _mm256_loadu_si256((const __m256i *)(IOTime + i));
+        mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, one)));
+        if (i + 3 + f + __builtin_popcount(mask) >= length)
+            break;
+        _mm256_storeu_si256((__m256i *)(IOTime + i), _mm256_sub_epi64(v, one));
+        for (; mask != 0; mask &= mask - 1)
+            done[f++] = i + __builtin_ctz(mask);
+    }
+    *finished = f;
+    return countdown_scalar(IOTime, i, length, done, finished);
+}
+
+__attribute__((target("sse4.1,popcnt"))) static unsigned long countdown_sse41(unsigned long *IOTime, unsigned long start,
+                                                                            unsigned long length, unsigned int *done,
+                                                                            unsigned long *finished)
+{
+    const __m128i one = _mm_set1_epi64x(1);
+    unsigned long i, f = *finished;
+    unsigned int mask;
+    __m128i v;
+
+    for (i = start; i + 2 <= length; i += 2)
+    {
+        v = _mm_loadu_si128((const __m128i *)(IOTime + i));
+        mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, one)));
+        if (i + 1 + f + __builtin_popcount(mask) >= length)
+            break;
+        _mm_storeu_si128((__m128i *)(IOTime + i), _mm_sub_epi64(v, one));
+        for (; mask != 0; mask &= mask - 1)
+            done[f++] = i + __builtin_ctz(mask);
+    }
+    *finished = f;
+    return countdown_scalar(IOTime, i, length, done, finished);
+}
+#endif
+
+static CountdownKernel kernel = NULL;
+static const char *kernelName = "scalar";
+
+static void select_kernel(void)
+{
+    kernel = countdown_scalar;
+#if defined(IOWAIT_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    {
+        kernel = countdown_avx2;
+        kernelName = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt"))
+    {
+        kernel = countdown_sse41;
+        kernelName = "sse4.1";
+    }
+#endif
+}
+
+const char *iowait_kernel(void)
+{
+    if (kernel == NULL)
+        select_kernel();
+    return kernelName;
+}
+
+void init_iowait_set(IOWaitSet *s)
+{
+    memset(s, 0, sizeof(IOWaitSet));
+    if (kernel == NULL)
+        select_kernel();
+}
+
+void destroy_iowait_set(IOWaitSet *s)
+{
+    free(s->IOTime);
+    free(s->slot);
+    free(s->spareIOTime);
+    free(s->spareSlot);
+    free(s->pool);
+    free(s->freeSlots);
+    free(s->done);
+    free(s->completed);
+    memset(s, 0, sizeof(IOWaitSet));
+}
+
+static void *grow(void *buffer, unsigned long capacity, size_t elementSize)
+{
+    buffer = realloc(buffer, capacity * elementSize);
+    if (buffer == NULL)
+    {
+        fprintf(stderr, "realloc() failed in function add_to_iowait_set()\n");
+        exit(1);
+    }
+    return buffer;
+}
+
+void add_to_iowait_set(IOWaitSet *s, const Process *p)
+{
+    unsigned long capacity, i;
+    unsigned int slot;
+
+    if (s->freeCount == 0)
+    {
+        capacity = s->capacity ? 2 * s->capacity : 64;
+        s->IOTime = grow(s->IOTime, capacity, sizeof(unsigned long));
+        s->slot = grow(s->slot, capacity, sizeof(unsigned int));
+        s->spareIOTime = grow(s->spareIOTime, capacity, sizeof(unsigned long));
+        s->spareSlot = grow(s->spareSlot, capacity, sizeof(unsigned int));
+        s->pool = grow(s->pool, capacity, sizeof(Process));
+        s->freeSlots = grow(s->freeSlots, capacity, sizeof(unsigned int));
+        s->done = grow(s->done, capacity, sizeof(unsigned int));
+        s->completed = grow(s->completed, capacity, sizeof(Process));
+        for (i = capacity; i-- > s->capacity;)
+            s->freeSlots[s->freeCount++] = i;
+        s->capacity = capacity;
+    }
+
+    slot = s->freeSlots[--s->freeCount];
+    s->pool[slot] = *p;
+    s->IOTime[s->length] = p->IOTime;
+    s->slot[s->length++] = slot;
+    if (s->length > s->peakLength)
+        s->peakLength = s->length;
+}
+
+void iowait_memory(const IOWaitSet *s, Queue_memory *m)
+{
+    m->nodes = s->length;
+    m->peak_nodes = s->peakLength;
+    m->bytes = s->capacity * (2 * sizeof(unsigned long) + 4 * sizeof(unsigned int) + 2 * sizeof(Process));
+    m->peak_bytes = m->bytes;
+}
+
+unsigned long iowait_length(const IOWaitSet *s)
+{
+    return s->length;
+}
+
+unsigned long do_iowait_tick(IOWaitSet *s, Process **completed)
+{
+    unsigned long processed, finished = 0, kept, from, to, i;
+    unsigned long *swapIOTime;
+    unsigned int *swapSlot;
+    Process *p;
+
+    *completed = s->completed;
+    if (s->length == 0)
+        return 0;
+
+    processed = kernel(s->IOTime, 0, s->length, s->done, &finished);
+    if (finished == 0)
+        return 0; // every process was visited, the order is unchanged
+
+    for (i = 0; i < finished; i++)
+    {
+        p = &(s->pool[s->slot[s->done[i]]]);
+        p->IOTime = 1; // the kernel did the last tick of the burst, do_IO() applies what follows it
+        do_IO(p);
+        s->completed[i] = *p;
+        s->freeSlots[s->freeCount++] = s->slot[s->done[i]];
+    }
+
+    // the unvisited processes, then the visited ones that still need IO
+    kept = s->length - processed;
+    memcpy(s->spareIOTime, s->IOTime + processed, kept * sizeof(unsigned long));
+    memcpy(s->spareSlot, s->slot + processed, kept * sizeof(unsigned int));
+    for (i = 0, from = 0; i <= finished; i++, from = to + 1)
+    {
+        to = (i < finished) ? s->done[i] : processed;
+        memcpy(s->spareIOTime + kept, s->IOTime + from, (to - from) * sizeof(unsigned long));
+        memcpy(s->spareSlot + kept, s->slot + from, (to - from) * sizeof(unsigned int));
+        kept += to - from;
+    }
+
+    swapIOTime = s->IOTime;
+    s->IOTime = s->spareIOTime;
+    s->spareIOTime = swapIOTime;
+    swapSlot = s->slot;
+    s->slot = s->spareSlot;
+    s->spareSlot = swapSlot;
+    s->length = kept;
+    return finished;
+}
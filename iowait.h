@@ -0,0 +1,71 @@
+#if !defined(IOWAIT_TYPE_DEFINED)
+#define IOWAIT_TYPE_DEFINED
+
+#include "prioque.h"
+#include "process.h"
+
+/* Set of the processes blocked for IO, in FIFO order.
+
+   The remaining IO time of every blocked process is kept in one
+   contiguous array, in queue order, next to the slot of the process in
+   a pool that does not move.  One tick of IO then is a single pass
+   over that array which decrements the counters and collects the
+   processes finishing their IO burst, with AVX2 or SSE4.1 when the CPU
+   has them and a scalar loop otherwise (or when built with
+   -DIOWAIT_NO_SIMD).  The order of the processes after a tick and the
+   processes visited are exactly those of the tick of the IOQueue it
+   replaces: a tick stops once it visited as many processes as are
+   still blocked, and the unvisited processes stay in front of the
+   visited ones that still need IO.
+*/
+typedef struct IOWaitSet
+{
+    unsigned long *IOTime;      // remaining IO time of the blocked processes, in queue order
+    unsigned int *slot;         // pool slot of each of them
+    unsigned long *spareIOTime; // second buffers the order is rebuilt into when processes leave
+    unsigned int *spareSlot;
+    unsigned long length;       // number of blocked processes
+    unsigned long capacity;     // room in the order buffers and the pool
+    unsigned long peakLength;   // most processes blocked at once
+    Process *pool;              // the blocked processes, their IOTime is only valid in 'IOTime'
+    unsigned int *freeSlots;    // stack of the unused pool slots
+    unsigned long freeCount;
+    unsigned int *done;         // queue positions finishing IO in the current tick
+    Process *completed;         // processes that finished IO in the last tick, in queue order
+} IOWaitSet;
+
+/* initializes an empty set
+*/
+void init_iowait_set(IOWaitSet *s);
+
+/* frees the buffers of 's'; processes still blocked keep their program
+   references, like the elements of a destroyed queue
+*/
+void destroy_iowait_set(IOWaitSet *s);
+
+/* blocks a copy of process 'p' behind the processes already blocked
+*/
+void add_to_iowait_set(IOWaitSet *s, const Process *p);
+
+/* returns the number of blocked processes
+*/
+unsigned long iowait_length(const IOWaitSet *s);
+
+/* does one tick of IO and returns the number of processes that
+   finished their IO burst.  They are removed from the set, with
+   do_IO() applied, and stored in queue order in 'completed', which
+   stays valid until the next call.
+*/
+unsigned long do_iowait_tick(IOWaitSet *s, Process **completed);
+
+/* stores the memory held by 's' in 'm', one node per blocked process.
+   The buffers are sized for the peak and never shrink.
+*/
+void iowait_memory(const IOWaitSet *s, Queue_memory *m);
+
+/* returns the name of the countdown kernel in use: "avx2", "sse4.1" or
+   "scalar"
+*/
+const char *iowait_kernel(void);
+
+#endif
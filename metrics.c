@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include "metrics.h"
+
+LiveMetrics *create_metrics(const char *name)
+{
+    LiveMetrics *m;
+    int fd;
+
+    fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0)
+        return NULL;
+    if (ftruncate(fd, sizeof(LiveMetrics)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    m = mmap(NULL, sizeof(LiveMetrics), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return NULL;
+
+    // the segment is zero filled, the magic goes last so readers never see a partial header
+    m->version = METRICS_VERSION;
+    __atomic_store_n(&(m->magic), METRICS_MAGIC, __ATOMIC_RELEASE);
+    return m;
+}
+
+const LiveMetrics *attach_metrics(const char *name)
+{
+    LiveMetrics *m;
+    int fd;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+    m = mmap(NULL, sizeof(LiveMetrics), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return NULL;
+
+    if (__atomic_load_n(&(m->magic), __ATOMIC_ACQUIRE) != METRICS_MAGIC || m->version != METRICS_VERSION)
+    {
+        munmap(m, sizeof(LiveMetrics));
+        return NULL;
+    }
+    return m;
+}
+
+void publish_metrics(LiveMetrics *m, const MetricsValues *v)
+{
+    unsigned long *to = (unsigned long *)&(m->values);
+    const unsigned long *from = (const unsigned long *)v;
+    unsigned long sequence = m->sequence, i;
+
+    __atomic_store_n(&(m->sequence), sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (i = 0; i < METRICS_FIELDS; i++)
+        __atomic_store_n(&to[i], from[i], __ATOMIC_RELAXED);
+    __atomic_store_n(&(m->sequence), sequence + 2, __ATOMIC_RELEASE);
+}
+
+void read_metrics(const LiveMetrics *m, MetricsValues *v)
+{
+    const unsigned long *from = (const unsigned long *)&(m->values);
+    unsigned long *to = (unsigned long *)v;
+    unsigned long before, i;
+
+    for (;;)
+    {
+        before = __atomic_load_n(&(m->sequence), __ATOMIC_ACQUIRE);
+        if (before & 1)
+        {
+            sched_yield();
+            continue;
+        }
+        for (i = 0; i < METRICS_FIELDS; i++)
+            to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&(m->sequence), __ATOMIC_RELAXED) == before)
+            return;
+    }
+}
+
+void detach_metrics(const LiveMetrics *m, const char *name)
+{
+    munmap((void *)m, sizeof(LiveMetrics));
+    if (name != NULL)
+        shm_unlink(name);
+}
@@ -0,0 +1,62 @@
+#if !defined(METRICS_TYPE_DEFINED)
+#define METRICS_TYPE_DEFINED
+
+#define METRICS_MAGIC 0x4d4c4651UL // "MLFQ", marks an initialized segment
+#define METRICS_VERSION 2UL
+
+// Live counters of a running simulation, all unsigned longs so each is read and written atomically
+typedef struct MetricsValues
+{
+    unsigned long CPUclock;        // current time of the simulation
+    unsigned long readyLength[3];  // lengths of the High, Medium and Low queues
+    unsigned long IOLength;        // length of the IOQueue
+    unsigned long idleTicks;       // ticks the <<null>> process ran
+    unsigned long contextSwitches; // dispatches of a process other than the last one dispatched
+    unsigned long dispatches;      // processes dispatched, including the one that ran last
+    unsigned long promotions;      // processes moved up a level
+    unsigned long demotions;       // processes moved down a level
+    unsigned long events;          // report lines written (CREATE, RUN, QUEUED, I/O, FINISHED)
+    unsigned long eventsPerSecond; // event rate since the previous publish, in wall clock time
+    unsigned long finished;        // nonzero once the simulation has ended
+} MetricsValues;
+
+#define METRICS_FIELDS (sizeof(MetricsValues) / sizeof(unsigned long))
+
+/* Shared memory segment the scheduler publishes its counters in.
+   'sequence' is a seqlock: the single writer makes it odd while it
+   updates 'values' and even again afterwards, so readers take no lock
+   and never stall the scheduler; they retry a copy that overlapped an
+   update.
+*/
+typedef struct LiveMetrics
+{
+    unsigned long magic;
+    unsigned long version;
+    unsigned long sequence;
+    MetricsValues values;
+} LiveMetrics;
+
+/* creates (or replaces) the shared memory object 'name' (e.g. "/mlfqs")
+   and maps it for writing.  Returns NULL on failure with errno set.
+*/
+LiveMetrics *create_metrics(const char *name);
+
+/* maps the existing shared memory object 'name' read-only.  Returns
+   NULL on failure, or if it does not hold a LiveMetrics segment.
+*/
+const LiveMetrics *attach_metrics(const char *name);
+
+/* writer: copies 'v' into the segment
+*/
+void publish_metrics(LiveMetrics *m, const MetricsValues *v);
+
+/* reader: copies a consistent snapshot of the segment into 'v'
+*/
+void read_metrics(const LiveMetrics *m, MetricsValues *v);
+
+/* unmaps 'm'; if 'name' is not NULL the shared memory object is also
+   removed, processes still attached keep their mapping
+*/
+void detach_metrics(const LiveMetrics *m, const char *name);
+
+#endif
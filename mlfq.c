@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mlfq.h"
+
+#define ARRIVAL_BATCH 256 // processes handed to an arrival queue per batch while loading
+
+const unsigned int levelQuantum[MLFQ_LEVELS] = {LEVEL_1_QUANTUM, LEVEL_2_QUANTUM, LEVEL_3_QUANTUM};
+const unsigned int levelPromoteFactor[MLFQ_LEVELS] = {3, 2, 1};
+const unsigned int levelDemoteFactor[MLFQ_LEVELS] = {1, 2, 1};
+
+// reset demoteFactor, promoteFactor, quantum coressponding to the new priority
+static void enter_level(Process *p, int level)
+{
+    p->priority = level;
+    p->quantum = levelQuantum[level - 1];
+    p->promoteFactor = levelPromoteFactor[level - 1];
+    p->demoteFactor = levelDemoteFactor[level - 1];
+}
+
+void reset_to_top_level(Process *p)
+{
+    enter_level(p, 1);
+}
+
+int quantum_expired(Process *p)
+{
+    // reset quantum for priority 3
+    if (p->priority >= MLFQ_LEVELS)
+    {
+        p->quantum = levelQuantum[MLFQ_LEVELS - 1];
+        return FALSE;
+    }
+
+    // demote process for priority 1 & 2
+    p->demoteFactor--;
+    if (p->demoteFactor > 0)
+        return FALSE;
+    enter_level(p, p->priority + 1);
+    return TRUE;
+}
+
+int blocked_for_io(Process *p)
+{
+    // reset quantum for priority 1
+    if (p->priority <= 1)
+    {
+        p->quantum = levelQuantum[0];
+        return FALSE;
+    }
+
+    // promote process for priority 2 & 3
+    p->promoteFactor--;
+    if (p->promoteFactor > 0)
+        return FALSE;
+    enter_level(p, p->priority - 1);
+    return TRUE;
+}
+
+/* Stable LSD radix sort of the indices in 'order' by keys[index], 8 bits per pass.
+   Passes where every key has the same byte are skipped. 'scratch' must hold 'count' indices.
+*/
+static void radix_sort_by_key(const unsigned int *keys, unsigned long *order, unsigned long *scratch, unsigned long count)
+{
+    unsigned long offsets[256], *from = order, *to = scratch, *swap, i, total, n;
+    unsigned int shift, byte;
+
+    if (count == 0)
+        return;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+        memset(offsets, 0, sizeof(offsets));
+        for (i = 0; i < count; i++)
+            offsets[(keys[from[i]] >> shift) & 0xff]++;
+        if (offsets[(keys[from[0]] >> shift) & 0xff] == count)
+            continue;
+
+        for (byte = 0, total = 0; byte < 256; byte++)
+        {
+            n = offsets[byte];
+            offsets[byte] = total;
+            total += n;
+        }
+        for (i = 0; i < count; i++)
+            to[offsets[(keys[from[i]] >> shift) & 0xff]++] = from[i];
+
+        swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != order)
+        memcpy(order, from, count * sizeof(unsigned long));
+}
+
+void build_arrival_queue(Queue *q, const Process *arrivals, unsigned long count)
+{
+    Process batch[ARRIVAL_BATCH];
+    int priorities[ARRIVAL_BATCH];
+    unsigned int *keys = malloc(count * sizeof(unsigned int) + 1);
+    unsigned long *order = malloc(count * sizeof(unsigned long) + 1);
+    unsigned long *scratch = malloc(count * sizeof(unsigned long) + 1);
+    unsigned long i, batched;
+
+    if (keys == NULL || order == NULL || scratch == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function build_arrival_queue()\n");
+        exit(1);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        keys[i] = arrivals[i].arrival_time;
+        order[i] = i;
+    }
+    radix_sort_by_key(keys, order, scratch, count);
+
+    for (i = 0, batched = 0; i < count; i++)
+    {
+        batch[batched] = arrivals[order[i]];
+        priorities[batched] = arrivals[order[i]].arrival_time;
+        if (++batched == ARRIVAL_BATCH || i == count - 1)
+        {
+            add_batch_to_queue(q, batch, priorities, batched);
+            batched = 0;
+        }
+    }
+
+    free(keys);
+    free(order);
+    free(scratch);
+}
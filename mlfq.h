@@ -0,0 +1,52 @@
+#if !defined(MLFQ_TYPE_DEFINED)
+#define MLFQ_TYPE_DEFINED
+
+#include "prioque.h"
+#include "process.h"
+
+/* MLFQ policy shared by the single CPU simulator (MLFQS.c) and the
+   multi-CPU one (multicpu.c): the quantum and factors of every level,
+   when a process moves between levels, and how the arrivals of a trace
+   are queued.  Counting and reporting the moves is left to the
+   callers.
+*/
+
+#define MLFQ_LEVELS 3       // number of levels, 1 highest
+#define LEVEL_1_QUANTUM 10  // quantum of the highest level
+#define LEVEL_2_QUANTUM 30
+#define LEVEL_3_QUANTUM 100 // quantum of the lowest level
+
+/* quantum, promote factor and demote factor a process gets on entering
+   level i + 1.  The MLFQ executors (executor.c, coroutine.c) use the
+   same tables, so they follow the rules the simulator models.
+*/
+extern const unsigned int levelQuantum[MLFQ_LEVELS];
+extern const unsigned int levelPromoteFactor[MLFQ_LEVELS];
+extern const unsigned int levelDemoteFactor[MLFQ_LEVELS];
+
+/* puts 'p' back on level 1 with the initial quantum and factors
+*/
+void reset_to_top_level(Process *p);
+
+/* applies the rule for a process that used up its quantum without
+   blocking or finishing: levels 1 and 2 count down the demote factor
+   and move the process down a level when it reaches 0, level 3 gets a
+   new quantum.  Returns TRUE if the process moved down.
+*/
+int quantum_expired(Process *p);
+
+/* applies the rule for a process blocking for IO: levels 2 and 3 count
+   down the promote factor and move the process up a level when it
+   reaches 0, level 1 gets a new quantum.  Returns TRUE if the process
+   moved up.
+*/
+int blocked_for_io(Process *p);
+
+/* adds the 'count' processes in 'arrivals' to arrival queue 'q',
+   ordered by arrival time and keeping their order among equal times.
+   The processes are radix sorted and handed to the queue in already
+   ordered batches, so the build is linear.
+*/
+void build_arrival_queue(Queue *q, const Process *arrivals, unsigned long count);
+
+#endif
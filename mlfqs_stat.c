@@ -0,0 +1,98 @@
+/* mlfqs_stat: shows the live counters a scheduler started with
+   '-m name' publishes.  It only maps the segment read-only, so
+   watching never slows the simulation down.
+
+   usage: mlfqs_stat [-o] [-i interval_ms] [-n count] name
+
+   Without -o a line is printed every interval until the simulation
+   ends (or 'count' lines were printed); -o prints one key=value
+   snapshot for scrapers and exits.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "metrics.h"
+
+static void print_snapshot(const MetricsValues *v)
+{
+    printf("clock=%lu\n", v->CPUclock);
+    printf("ready_high=%lu\nready_medium=%lu\nready_low=%lu\n", v->readyLength[0], v->readyLength[1], v->readyLength[2]);
+    printf("io=%lu\n", v->IOLength);
+    printf("idle_ticks=%lu\n", v->idleTicks);
+    printf("context_switches=%lu\ndispatches=%lu\n", v->contextSwitches, v->dispatches);
+    printf("promotions=%lu\ndemotions=%lu\n", v->promotions, v->demotions);
+    printf("events=%lu\nevents_per_second=%lu\n", v->events, v->eventsPerSecond);
+    printf("finished=%lu\n", v->finished);
+}
+
+static void print_line(const MetricsValues *v, unsigned long lines)
+{
+    if (lines % 20 == 0)
+        printf("%12s %8s %8s %8s %8s %10s %10s %8s %8s %10s\n", "clock", "high", "medium", "low", "io", "idle",
+               "switches", "promo", "demo", "events/s");
+    printf("%12lu %8lu %8lu %8lu %8lu %10lu %10lu %8lu %8lu %10lu\n", v->CPUclock, v->readyLength[0], v->readyLength[1],
+           v->readyLength[2], v->IOLength, v->idleTicks, v->contextSwitches, v->promotions, v->demotions, v->eventsPerSecond);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    const LiveMetrics *m;
+    MetricsValues v;
+    struct timespec interval;
+    long milliseconds = 1000, count = 0;
+    unsigned long lines;
+    int opt, once = 0;
+
+    while ((opt = getopt(argc, argv, "oi:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            once = 1;
+            break;
+        case 'i':
+            milliseconds = atol(optarg);
+            break;
+        case 'n':
+            count = atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-o] [-i interval_ms] [-n count] name\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1 || milliseconds <= 0)
+    {
+        fprintf(stderr, "usage: %s [-o] [-i interval_ms] [-n count] name\n", argv[0]);
+        return 1;
+    }
+
+    m = attach_metrics(argv[optind]);
+    if (m == NULL)
+    {
+        fprintf(stderr, "%s: no scheduler metrics published under %s\n", argv[0], argv[optind]);
+        return 1;
+    }
+
+    read_metrics(m, &v);
+    if (once)
+        print_snapshot(&v);
+    else
+    {
+        interval.tv_sec = milliseconds / 1000;
+        interval.tv_nsec = (milliseconds % 1000) * 1000000;
+        for (lines = 0;; lines++)
+        {
+            print_line(&v, lines);
+            if (v.finished || (count > 0 && lines + 1 >= (unsigned long)count))
+                break;
+            nanosleep(&interval, NULL);
+            read_metrics(m, &v);
+        }
+    }
+
+    detach_metrics(m, NULL);
+    return 0;
+}
@@ -0,0 +1,582 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "ingest.h"
+#include "multicpu.h"
+#include "mlfq.h"
+
+// Struct of a host thread and the group of CPUs it simulates
+typedef struct HostThread
+{
+    pthread_t thread;
+    unsigned int first, last; // simulates CPUs first..last-1
+} HostThread;
+
+static SimulatedCPU *CPUs;
+static unsigned int CPUCount;
+static unsigned int lookaheadTicks;
+static Queue arrivals;          // processes not handed to a CPU yet, by arrival time
+static pthread_barrier_t windowStart, windowEnd;
+static int simulationDone = FALSE;
+
+// Every CPU event is kept until the boundary merges the events of all CPUs
+static void record_event(SimulatedCPU *c, int type, const Process *p)
+{
+    SchedulerEvent *e;
+
+    if (c->eventCount == c->eventCapacity)
+    {
+        c->eventCapacity = c->eventCapacity ? 2 * c->eventCapacity : 1024;
+        c->events = realloc(c->events, c->eventCapacity * sizeof(SchedulerEvent));
+        if (c->events == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function record_event()\n");
+            exit(1);
+        }
+    }
+    e = &(c->events[c->eventCount++]);
+    e->type = type;
+    e->PID = p->PID;
+    e->level = p->priority;
+    e->time = c->CPUclock;
+    e->ticks = (type == EVENT_FINISHED) ? p->CPU_Usage : p->CPUTime;
+}
+
+static void post_migration(SimulatedCPU *c, const Process *p)
+{
+    if (c->mailCount == c->mailCapacity)
+    {
+        c->mailCapacity = c->mailCapacity ? 2 * c->mailCapacity : 64;
+        c->mailbox = realloc(c->mailbox, c->mailCapacity * sizeof(Process));
+        if (c->mailbox == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function post_migration()\n");
+            exit(1);
+        }
+    }
+    c->mailbox[c->mailCount++] = *p;
+    c->load--;
+}
+
+// Keeps the program of finished process 'p' until the boundary releases it on the main thread
+static void retire_process(SimulatedCPU *c, Process *p)
+{
+    if (c->retiredCount == c->retiredCapacity)
+    {
+        c->retiredCapacity = c->retiredCapacity ? 2 * c->retiredCapacity : 64;
+        c->retired = realloc(c->retired, c->retiredCapacity * sizeof(const BehaviorProgram *));
+        if (c->retired == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function retire_process()\n");
+            exit(1);
+        }
+    }
+    c->retired[c->retiredCount++] = p->program;
+    p->program = NULL;
+    p->nextBehavior = 0;
+}
+
+static void init_cpu(SimulatedCPU *c, unsigned int id)
+{
+    c->id = id;
+    init_queue(&(c->ArrivalQueue), sizeof(Process), TRUE, process_compare, FALSE);
+    init_queue(&(c->HighQueue), sizeof(Process), FALSE, process_compare, FALSE);
+    init_queue(&(c->MediumQueue), sizeof(Process), FALSE, process_compare, FALSE);
+    init_queue(&(c->LowQueue), sizeof(Process), FALSE, process_compare, FALSE);
+    init_iowait_set(&(c->IOQueue));
+    init_process(&(c->IdleProcess));
+    init_process(&(c->frontReadyQ));
+    init_process(&(c->higherPriority));
+    c->exeProcess = &(c->IdleProcess);
+    c->quantum = 0;
+    c->result = FINISH;
+    c->CPUclock = 0;
+    c->load = 0;
+    c->lastBusyTick = 0;
+    c->events = NULL;
+    c->eventCount = c->eventCapacity = 0;
+    c->mailbox = NULL;
+    c->mailCount = c->mailCapacity = 0;
+    c->retired = NULL;
+    c->retiredCount = c->retiredCapacity = 0;
+    c->handoff = NULL;
+    c->handoffTimes = NULL;
+    c->handoffCount = c->handoffCapacity = 0;
+    c->migrationTarget = id;
+    c->migrationQuota = 0;
+}
+
+static void destroy_cpu(SimulatedCPU *c)
+{
+    destroy_queue(&(c->ArrivalQueue));
+    destroy_queue(&(c->HighQueue));
+    destroy_queue(&(c->MediumQueue));
+    destroy_queue(&(c->LowQueue));
+    destroy_iowait_set(&(c->IOQueue));
+    free(c->events);
+    free(c->mailbox);
+    free(c->retired);
+    free(c->handoff);
+    free(c->handoffTimes);
+}
+
+////////////////// one CPU, the policy of MLFQS.c ///////////////////
+
+static void add_to_cpu_queue(SimulatedCPU *c, Process *p)
+{
+    if (p->priority == 1)
+        add_to_queue(&(c->HighQueue), p, p->quantum);
+    else if (p->priority == 2)
+        add_to_queue(&(c->MediumQueue), p, p->quantum);
+    else if (p->priority == 3)
+        add_to_queue(&(c->LowQueue), p, p->quantum);
+}
+
+static Queue *select_cpu_queue(SimulatedCPU *c, unsigned int *level)
+{
+    if (!empty_queue(&(c->HighQueue)))
+        *level = 1;
+    else if (!empty_queue(&(c->MediumQueue)))
+        *level = 2;
+    else if (!empty_queue(&(c->LowQueue)))
+        *level = 3;
+    else
+        return NULL;
+    return *level == 1 ? &(c->HighQueue) : *level == 2 ? &(c->MediumQueue) : &(c->LowQueue);
+}
+
+static void dispatch_cpu_front(SimulatedCPU *c)
+{
+    c->higherPriority = c->frontReadyQ;
+    c->exeProcess = &(c->higherPriority);
+    c->quantum = c->exeProcess->quantum;
+    record_event(c, EVENT_RUN, c->exeProcess);
+}
+
+static void admit_cpu_arrivals(SimulatedCPU *c)
+{
+    const Process *nextArrival;
+    Process currentProcess;
+
+    while ((nextArrival = peek_front(&(c->ArrivalQueue), NULL)) != NULL && nextArrival->arrival_time <= (unsigned int)c->CPUclock)
+    {
+        remove_from_front(&(c->ArrivalQueue), &currentProcess);
+        load_next_behavior(&currentProcess);
+        add_to_cpu_queue(c, &currentProcess);
+        record_event(c, EVENT_CREATE, &currentProcess);
+    }
+}
+
+// execute_highest_priority_process() of MLFQS.c on CPU 'c'
+static void execute_on_cpu(SimulatedCPU *c)
+{
+    Queue *readyQueue;
+    unsigned int level;
+
+    if (c->quantum == 0 && c->result == NOT_FINISH)
+    {
+        quantum_expired(c->exeProcess);
+        add_to_cpu_queue(c, c->exeProcess);
+        record_event(c, EVENT_QUEUED, c->exeProcess);
+        c->exeProcess = &(c->IdleProcess);
+    }
+
+    if (c->result == DO_IO)
+    {
+        blocked_for_io(c->exeProcess);
+        record_event(c, EVENT_IO, c->exeProcess);
+        add_to_iowait_set(&(c->IOQueue), c->exeProcess);
+        c->exeProcess = &(c->IdleProcess);
+    }
+    else if (c->result == FINISH)
+    {
+        if (process_compare(&(c->IdleProcess), c->exeProcess))
+        {
+            record_event(c, EVENT_FINISHED, c->exeProcess);
+            retire_process(c, c->exeProcess);
+            c->exeProcess = &(c->IdleProcess);
+            c->load--;
+        }
+    }
+
+    if (!process_compare(&(c->IdleProcess), c->exeProcess))
+    {
+        readyQueue = select_cpu_queue(c, &level);
+        if (readyQueue != NULL)
+        {
+            remove_from_front(readyQueue, &(c->frontReadyQ));
+            dispatch_cpu_front(c);
+        }
+    }
+    else
+    {
+        readyQueue = select_cpu_queue(c, &level);
+        if (readyQueue != NULL && level < c->exeProcess->priority)
+        {
+            remove_from_front(readyQueue, &(c->frontReadyQ));
+            record_event(c, EVENT_QUEUED, c->exeProcess);
+            c->exeProcess->quantum = c->quantum;
+            add_to_cpu_queue(c, c->exeProcess);
+            dispatch_cpu_front(c);
+        }
+    }
+
+    c->result = exec_process(c->exeProcess);
+    c->quantum--;
+}
+
+// do_io_for_processes() of MLFQS.c on CPU 'c', processes within the migration quota leave for the mailbox
+static void do_cpu_io(SimulatedCPU *c)
+{
+    Process *completed;
+    unsigned long finished, i;
+
+    finished = do_iowait_tick(&(c->IOQueue), &completed);
+    for (i = 0; i < finished; i++)
+    {
+        if (c->migrationQuota > 0)
+        {
+            c->migrationQuota--;
+            post_migration(c, &completed[i]);
+        }
+        else
+            add_to_cpu_queue(c, &completed[i]);
+    }
+}
+
+static void run_cpu_window(SimulatedCPU *c)
+{
+    unsigned int t;
+
+    for (t = 0; t < lookaheadTicks; t++)
+    {
+        c->CPUclock++;
+        if (c->load > 0)
+            c->lastBusyTick = c->CPUclock;
+        admit_cpu_arrivals(c);
+        execute_on_cpu(c);
+        do_cpu_io(c);
+    }
+}
+
+////////////////// window boundaries ///////////////////
+
+static void *simulate_cpu_group(void *arg)
+{
+    HostThread *h = (HostThread *)arg;
+    unsigned int i;
+
+    for (;;)
+    {
+        pthread_barrier_wait(&windowStart);
+        if (simulationDone)
+            return NULL;
+        for (i = h->first; i < h->last; i++)
+            run_cpu_window(&CPUs[i]);
+        pthread_barrier_wait(&windowEnd);
+    }
+}
+
+// Moves the processes posted in the mailboxes to their target CPUs, in CPU order
+static void deliver_migrations(void)
+{
+    SimulatedCPU *target;
+    unsigned long i, j;
+
+    for (i = 0; i < CPUCount; i++)
+    {
+        target = &CPUs[CPUs[i].migrationTarget];
+        for (j = 0; j < CPUs[i].mailCount; j++)
+        {
+            add_to_cpu_queue(target, &(CPUs[i].mailbox[j]));
+            target->load++;
+        }
+        CPUs[i].mailCount = 0;
+    }
+}
+
+static unsigned int least_loaded_cpu(void)
+{
+    unsigned int i, best = 0;
+
+    for (i = 1; i < CPUCount; i++)
+    {
+        if (CPUs[i].load < CPUs[best].load)
+            best = i;
+    }
+    return best;
+}
+
+static void hand_off_arrival(SimulatedCPU *c, const Process *p)
+{
+    if (c->handoffCount == c->handoffCapacity)
+    {
+        c->handoffCapacity = c->handoffCapacity ? 2 * c->handoffCapacity : 64;
+        c->handoff = realloc(c->handoff, c->handoffCapacity * sizeof(Process));
+        c->handoffTimes = realloc(c->handoffTimes, c->handoffCapacity * sizeof(int));
+        if (c->handoff == NULL || c->handoffTimes == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function hand_off_arrival()\n");
+            exit(1);
+        }
+    }
+    c->handoff[c->handoffCount] = *p;
+    c->handoffTimes[c->handoffCount++] = p->arrival_time;
+    c->load++;
+}
+
+/* Hands the arrivals up to 'until' to the CPUs holding the fewest
+   processes.  They come out of 'arrivals' in arrival order, so every
+   CPU gets its share as one ordered batch.
+*/
+static void assign_arrivals(unsigned int until)
+{
+    const Process *next;
+    Process p;
+    unsigned int i;
+
+    while ((next = peek_front(&arrivals, NULL)) != NULL && next->arrival_time <= until)
+    {
+        remove_from_front(&arrivals, &p);
+        hand_off_arrival(&CPUs[least_loaded_cpu()], &p);
+    }
+    for (i = 0; i < CPUCount; i++)
+    {
+        if (CPUs[i].handoffCount > 0)
+            add_batch_to_queue(&(CPUs[i].ArrivalQueue), CPUs[i].handoff, CPUs[i].handoffTimes, CPUs[i].handoffCount);
+        CPUs[i].handoffCount = 0;
+    }
+}
+
+/* Gives every CPU holding more than the rounded up average load a quota
+   of migrations to the CPU with the largest deficit below the average
+*/
+static void plan_migrations(void)
+{
+    unsigned long total = 0, ceiling, floor, surplus, best, deficit[CPUCount];
+    unsigned int i, j, target;
+
+    for (i = 0; i < CPUCount; i++)
+        total += CPUs[i].load;
+    floor = total / CPUCount;
+    ceiling = (total + CPUCount - 1) / CPUCount;
+    for (i = 0; i < CPUCount; i++)
+        deficit[i] = CPUs[i].load < floor ? floor - CPUs[i].load : 0;
+
+    for (i = 0; i < CPUCount; i++)
+    {
+        CPUs[i].migrationTarget = i;
+        CPUs[i].migrationQuota = 0;
+        if (CPUs[i].load <= ceiling)
+            continue;
+
+        for (j = 0, best = 0, target = i; j < CPUCount; j++)
+        {
+            if (deficit[j] > best)
+            {
+                best = deficit[j];
+                target = j;
+            }
+        }
+        if (best == 0)
+            continue;
+        surplus = CPUs[i].load - ceiling;
+        CPUs[i].migrationTarget = target;
+        CPUs[i].migrationQuota = surplus < best ? surplus : best;
+        deficit[target] -= CPUs[i].migrationQuota;
+    }
+}
+
+/* Writes the events of the window ending at 'end' in (time, CPU) order,
+   finished processes also go to 'report' and their programs are released
+*/
+static void end_window(int end, FILE *report)
+{
+    unsigned long next[CPUCount], j;
+    const SchedulerEvent *e;
+    unsigned int i;
+    int t;
+
+    for (i = 0; i < CPUCount; i++)
+        next[i] = 0;
+    for (t = end - lookaheadTicks + 1; t <= end; t++)
+    {
+        for (i = 0; i < CPUCount; i++)
+        {
+            for (; next[i] < CPUs[i].eventCount && CPUs[i].events[next[i]].time == t; next[i]++)
+            {
+                e = &(CPUs[i].events[next[i]]);
+                if (CPUCount > 1)
+                    printf("CPU %u: ", i);
+                format_event(stdout, e);
+                if (e->type == EVENT_FINISHED)
+                    fprintf(report, "Process %d:\t\t%lu time units.\n", e->PID, e->ticks);
+            }
+        }
+    }
+    for (i = 0; i < CPUCount; i++)
+    {
+        for (j = 0; j < CPUs[i].retiredCount; j++)
+            release_behavior_program(CPUs[i].retired[j]);
+        CPUs[i].eventCount = 0;
+        CPUs[i].retiredCount = 0;
+    }
+}
+
+static int cpus_empty(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < CPUCount; i++)
+    {
+        if (CPUs[i].load > 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void read_arrivals(void)
+{
+    IngestTable table;
+    TraceRecord r;
+    Process *processes;
+    unsigned long i;
+
+    init_queue(&arrivals, sizeof(Process), TRUE, process_compare, FALSE);
+    init_ingest_table(&table);
+    while (read_trace_record(stdin, &r))
+        ingest_behavior(&table, r.PID, r.arrival, &r.behavior);
+
+    processes = malloc(table.count * sizeof(Process) + 1);
+    if (processes == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function read_arrivals()\n");
+        exit(1);
+    }
+    for (i = 0; i < table.count; i++)
+    {
+        init_process(&processes[i]);
+        processes[i].PID = table.processes[i].PID;
+        processes[i].arrival_time = table.processes[i].arrival_time;
+        processes[i].program = intern_behavior_program(ingested_behaviors(&(table.processes[i])), table.processes[i].count);
+    }
+
+    // the queue keeps the processes of equal arrival times in the order of the trace, as the single CPU simulator does
+    build_arrival_queue(&arrivals, processes, table.count);
+    free(processes);
+    destroy_ingest_table(&table);
+}
+
+int run_multicpu_simulation(unsigned int cpus, unsigned int threads, unsigned int lookahead)
+{
+    HostThread *hosts;
+    FILE *report;
+    unsigned int i;
+    int boundary = 0, end = 0, c;
+
+    if (cpus == 0 || threads == 0 || lookahead == 0)
+    {
+        fprintf(stderr, "the number of CPUs, threads and the lookahead must be positive\n");
+        return 1;
+    }
+    if (threads > cpus)
+        threads = cpus;
+    report = tmpfile();
+    if (report == NULL)
+    {
+        perror("tmpfile");
+        return 1;
+    }
+
+    CPUCount = cpus;
+    lookaheadTicks = lookahead;
+    CPUs = malloc(cpus * sizeof(SimulatedCPU));
+    hosts = malloc(threads * sizeof(HostThread));
+    if (CPUs == NULL || hosts == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function run_multicpu_simulation()\n");
+        exit(1);
+    }
+    for (i = 0; i < cpus; i++)
+        init_cpu(&CPUs[i], i);
+    read_arrivals();
+
+    // with one thread the windows run on the calling thread
+    if (threads > 1)
+    {
+        pthread_barrier_init(&windowStart, NULL, threads + 1);
+        pthread_barrier_init(&windowEnd, NULL, threads + 1);
+        for (i = 0; i < threads; i++)
+        {
+            hosts[i].first = (unsigned long)cpus * i / threads;
+            hosts[i].last = (unsigned long)cpus * (i + 1) / threads;
+            if (pthread_create(&(hosts[i].thread), NULL, simulate_cpu_group, &hosts[i]) != 0)
+            {
+                fprintf(stderr, "pthread_create() failed in function run_multicpu_simulation()\n");
+                exit(1);
+            }
+        }
+    }
+
+    for (;;)
+    {
+        deliver_migrations();
+        if (cpus_empty() && empty_queue(&arrivals))
+            break;
+        assign_arrivals(boundary + lookahead);
+        plan_migrations();
+
+        if (threads > 1)
+        {
+            pthread_barrier_wait(&windowStart);
+            pthread_barrier_wait(&windowEnd);
+        }
+        else
+        {
+            for (i = 0; i < cpus; i++)
+                run_cpu_window(&CPUs[i]);
+        }
+        boundary += lookahead;
+        end_window(boundary, report);
+    }
+
+    if (threads > 1)
+    {
+        simulationDone = TRUE;
+        pthread_barrier_wait(&windowStart);
+        for (i = 0; i < threads; i++)
+            pthread_join(hosts[i].thread, NULL);
+        pthread_barrier_destroy(&windowStart);
+        pthread_barrier_destroy(&windowEnd);
+    }
+
+    // the system emptied at the last tick that started with processes on some CPU
+    for (i = 0; i < cpus; i++)
+    {
+        if (CPUs[i].lastBusyTick > end)
+            end = CPUs[i].lastBusyTick;
+    }
+    printf("Scheduler shutdown at time %d.\n", end);
+    printf("Total CPU usage for all processes scheduled:\n");
+    for (i = 0; i < cpus; i++)
+    {
+        // idle ticks simulated after the end do not count
+        if (cpus == 1)
+            printf("Process <<null>>:\t%d time units.\n", (int)CPUs[i].IdleProcess.CPU_Usage - (boundary - end) - 1);
+        else
+            printf("CPU %u <<null>>:\t%d time units.\n", i, (int)CPUs[i].IdleProcess.CPU_Usage - (boundary - end) - 1);
+    }
+    rewind(report);
+    while ((c = getc(report)) != EOF)
+        putchar(c);
+    putchar('\n');
+
+    fclose(report);
+    for (i = 0; i < cpus; i++)
+        destroy_cpu(&CPUs[i]);
+    destroy_queue(&arrivals);
+    destroy_behavior_programs();
+    free(CPUs);
+    free(hosts);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#if !defined(MULTICPU_TYPE_DEFINED)
+#define MULTICPU_TYPE_DEFINED
+
+#include "prioque.h"
+#include "process.h"
+#include "event.h"
+#include "iowait.h"
+
+/* Multi-CPU simulation, run as a parallel discrete event simulation.
+
+   Every simulated CPU is an MLFQ scheduler of its own, with the level
+   queues, IO and policy of the single CPU simulator.  CPUs interact
+   only at window boundaries, every 'lookahead' ticks:
+   o arrivals of the next window are handed to the CPU holding the
+     fewest processes (lowest index on ties)
+   o a CPU holding more processes than the average gets a quota of
+     processes to migrate to the least loaded CPU; a process finishing
+     IO within the quota is posted to the mailbox of that CPU instead
+     of its own ready queue and joins it at the next boundary, so the
+     lookahead is also the migration delay
+   Between boundaries the CPUs are independent, so each host thread
+   simulates a contiguous group of CPUs for a whole window.  Every
+   decision is taken on the state of the last boundary and mailboxes
+   are delivered in CPU order, which makes the schedule the same for
+   any number of host threads.  With one CPU the output is that of the
+   single CPU simulator.  Processes with a deadline run as ordinary
+   MLFQ processes, the real-time class is not simulated here, and
+   dispatching is free whatever the working set of a process.
+*/
+
+// Struct of the state of a simulated CPU
+typedef struct SimulatedCPU
+{
+    unsigned int id;
+    Queue ArrivalQueue, HighQueue, MediumQueue, LowQueue;
+    IOWaitSet IOQueue;
+    Process IdleProcess;    // the <<null>> process of this CPU
+    Process *exeProcess;    // either IdleProcess or higherPriority
+    Process frontReadyQ;    // the process in the front of the readyQueue
+    Process higherPriority; // the process being executed
+    int quantum;
+    int result;
+    int CPUclock;
+    unsigned long load;     // processes held: arriving, queued, blocked or running
+    int lastBusyTick;       // last tick that started with processes on this CPU
+
+    // outputs of the current window, collected at its boundary
+    SchedulerEvent *events;
+    unsigned long eventCount, eventCapacity;
+    Process *mailbox;       // processes migrating to 'migrationTarget'
+    unsigned long mailCount, mailCapacity;
+    const BehaviorProgram **retired; // programs of finished processes, the program table is not thread safe
+    unsigned long retiredCount, retiredCapacity;
+    Process *handoff;       // arrivals handed to this CPU at the current boundary
+    int *handoffTimes;      // their arrival times
+    unsigned long handoffCount, handoffCapacity;
+    unsigned int migrationTarget;
+    unsigned long migrationQuota; // processes that may still migrate in this window
+} SimulatedCPU;
+
+/* simulates the processes of the trace on stdin on 'cpus' CPUs with
+   'threads' host threads and windows of 'lookahead' ticks, writes the
+   events and the final report to stdout and returns the exit status
+*/
+int run_multicpu_simulation(unsigned int cpus, unsigned int threads, unsigned int lookahead);
+
+#endif
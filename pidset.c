@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pidset.h"
+
+#define WORD_BITS (8 * sizeof(unsigned long))
+
+// Returns the word holding the bit of 'pid', or NULL if its page was never allocated
+static unsigned long *find_word(const PIDSet *s, unsigned int pid)
+{
+    unsigned long page = pid / PIDSET_PAGE_BITS;
+
+    if (page >= s->pageCount || s->pages[page] == NULL)
+        return NULL;
+    return &(s->pages[page][(pid % PIDSET_PAGE_BITS) / WORD_BITS]);
+}
+
+void init_pid_set(PIDSet *s)
+{
+    memset(s, 0, sizeof(PIDSet));
+}
+
+void destroy_pid_set(PIDSet *s)
+{
+    unsigned long i;
+
+    for (i = 0; i < s->pageCount; i++)
+        free(s->pages[i]);
+    free(s->pages);
+    init_pid_set(s);
+}
+
+int pid_in_set(const PIDSet *s, unsigned int pid)
+{
+    unsigned long *word = find_word(s, pid);
+
+    return word != NULL && (*word >> (pid % WORD_BITS) & 1);
+}
+
+void add_to_pid_set(PIDSet *s, unsigned int pid)
+{
+    unsigned long page = pid / PIDSET_PAGE_BITS, count, *word;
+
+    if (page >= s->pageCount)
+    {
+        count = 2 * s->pageCount > page ? 2 * s->pageCount : page + 1;
+        s->pages = realloc(s->pages, count * sizeof(unsigned long *));
+        if (s->pages == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function add_to_pid_set()\n");
+            exit(1);
+        }
+        memset(s->pages + s->pageCount, 0, (count - s->pageCount) * sizeof(unsigned long *));
+        s->pageCount = count;
+    }
+    if (s->pages[page] == NULL)
+    {
+        s->pages[page] = calloc(PIDSET_PAGE_BITS / WORD_BITS, sizeof(unsigned long));
+        if (s->pages[page] == NULL)
+        {
+            fprintf(stderr, "calloc() failed in function add_to_pid_set()\n");
+            exit(1);
+        }
+    }
+
+    word = find_word(s, pid);
+    if (!(*word >> (pid % WORD_BITS) & 1))
+    {
+        *word |= 1UL << (pid % WORD_BITS);
+        s->count++;
+    }
+}
+
+void remove_from_pid_set(PIDSet *s, unsigned int pid)
+{
+    unsigned long *word = find_word(s, pid);
+
+    if (word != NULL && (*word >> (pid % WORD_BITS) & 1))
+    {
+        *word &= ~(1UL << (pid % WORD_BITS));
+        s->count--;
+    }
+}
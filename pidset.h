@@ -0,0 +1,40 @@
+#if !defined(PIDSET_TYPE_DEFINED)
+#define PIDSET_TYPE_DEFINED
+
+#define PIDSET_PAGE_BITS 4096 // PIDs covered by one page of the bitmap
+
+/* Set of PIDs, a bitmap split in pages of PIDSET_PAGE_BITS PIDs that
+   are only allocated once one of their PIDs is added.  Adding, looking
+   up and removing a PID take O(1), and the dense PIDs of a trace cost
+   one bit each however many processes come and go.  The page table
+   has one pointer per PIDSET_PAGE_BITS PIDs up to the largest PID
+   added, 8 MB for PIDs near the top of the range.
+*/
+typedef struct PIDSet
+{
+    unsigned long **pages;   // pages[pid / PIDSET_PAGE_BITS], NULL while none of its PIDs was added
+    unsigned long pageCount; // number of entries in 'pages'
+    unsigned long count;     // number of members
+} PIDSet;
+
+/* initializes an empty set
+*/
+void init_pid_set(PIDSet *s);
+
+/* frees the pages of 's', which is left empty
+*/
+void destroy_pid_set(PIDSet *s);
+
+/* returns nonzero if 'pid' is in 's'
+*/
+int pid_in_set(const PIDSet *s, unsigned int pid);
+
+/* adds 'pid' to 's', if it is not a member yet
+*/
+void add_to_pid_set(PIDSet *s, unsigned int pid);
+
+/* removes 'pid' from 's', if it is a member
+*/
+void remove_from_pid_set(PIDSet *s, unsigned int pid);
+
+#endif
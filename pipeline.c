@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "ring.h"
+#include "pipeline.h"
+#include "pidset.h"
+
+static Ring recordRing; // reader thread -> scheduler thread
+static Ring eventRing;  // scheduler thread -> writer thread
+static pthread_t readerThread, writerThread;
+
+/* Checks that the trace is ordered by arrival time and that the lines
+   of a process all give the same arrival time.  The serial reader
+   merges the lines of a PID into one process arriving at the time of
+   its last line, which the scheduler cannot know before the trace is
+   read to the end, so such traces are rejected.  'earlier' holds the
+   PIDs of the arrival times before the current one, 'current' those of
+   the current one.
+*/
+static void *read_trace(void *arg)
+{
+    TraceRecord r;
+    unsigned int lastArrival = 0;
+    PIDSet earlier;
+    unsigned int *current = NULL;
+    unsigned long currentCount = 0, currentCapacity = 0, i;
+
+    (void)arg; // the thread takes no argument
+    init_pid_set(&earlier);
+    while (read_trace_record(stdin, &r))
+    {
+        if (r.arrival < lastArrival)
+        {
+            fprintf(stderr, "pipelined mode requires a trace ordered by arrival time (process %u arrives at %u after %u)\n", r.PID, r.arrival, lastArrival);
+            exit(1);
+        }
+        if (r.arrival > lastArrival)
+        {
+            for (i = 0; i < currentCount; i++)
+                add_to_pid_set(&earlier, current[i]);
+            currentCount = 0;
+        }
+        if (pid_in_set(&earlier, r.PID))
+        {
+            fprintf(stderr, "pipelined mode requires every line of a process to give the same arrival time (process %u arrives at %u after an earlier time)\n", r.PID, r.arrival);
+            exit(1);
+        }
+        if (currentCount == currentCapacity)
+        {
+            currentCapacity = currentCapacity ? 2 * currentCapacity : 64;
+            current = realloc(current, currentCapacity * sizeof(unsigned int));
+            if (current == NULL)
+            {
+                fprintf(stderr, "realloc() failed in function read_trace()\n");
+                exit(1);
+            }
+        }
+        current[currentCount++] = r.PID;
+        lastArrival = r.arrival;
+        ring_put(&recordRing, &r);
+    }
+    destroy_pid_set(&earlier);
+    free(current);
+    close_ring(&recordRing);
+    return NULL;
+}
+
+static void *write_events(void *arg)
+{
+    SchedulerEvent e;
+
+    (void)arg; // the thread takes no argument
+    while (ring_get(&eventRing, &e))
+        write_event(&e);
+    return NULL;
+}
+
+void start_pipeline(void)
+{
+    init_ring(&recordRing, sizeof(TraceRecord), PIPELINE_RING_SIZE);
+    init_ring(&eventRing, sizeof(SchedulerEvent), PIPELINE_RING_SIZE);
+    if (pthread_create(&readerThread, NULL, read_trace, NULL) != 0 ||
+        pthread_create(&writerThread, NULL, write_events, NULL) != 0)
+    {
+        fprintf(stderr, "pthread_create() failed in function start_pipeline()\n");
+        exit(1);
+    }
+}
+
+const TraceRecord *peek_trace_record(void)
+{
+    return ring_peek(&recordRing);
+}
+
+void consume_trace_record(void)
+{
+    ring_advance(&recordRing);
+}
+
+void publish_event(const SchedulerEvent *e)
+{
+    ring_put(&eventRing, e);
+}
+
+void stop_pipeline(void)
+{
+    close_ring(&eventRing);
+    pthread_join(writerThread, NULL);
+    pthread_join(readerThread, NULL);
+    destroy_ring(&eventRing);
+    destroy_ring(&recordRing);
+}
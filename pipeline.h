@@ -0,0 +1,39 @@
+#if !defined(PIPELINE_TYPE_DEFINED)
+#define PIPELINE_TYPE_DEFINED
+
+#include "event.h"
+#include "ingest.h"
+
+#define PIPELINE_RING_SIZE 4096 // records or events buffered between two stages
+
+/* Three-stage pipeline: a reader thread parses trace records from stdin
+   into one ring, the scheduler thread (the caller) consumes them and
+   publishes events into a second ring, and a writer thread writes the
+   events to stdout and the timeline, if any.  The trace must be ordered by arrival time so the
+   scheduler can admit a process as soon as the reader has passed its
+   arrival time, and every line of a process must give the same arrival
+   time; the reader exits with an error otherwise.
+*/
+
+/* starts the reader and writer threads
+*/
+void start_pipeline(void);
+
+/* returns the next trace record without consuming it, waiting for the
+   reader if needed.  Returns NULL at the end of the trace.
+*/
+const TraceRecord *peek_trace_record(void);
+
+/* consumes the record returned by peek_trace_record()
+*/
+void consume_trace_record(void);
+
+/* hands event 'e' to the writer thread
+*/
+void publish_event(const SchedulerEvent *e);
+
+/* waits until every published event was written, then stops both threads
+*/
+void stop_pipeline(void);
+
+#endif
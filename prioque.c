@@ -8,16 +8,38 @@
 // code, which will require minor modifications.  See prioque.h for
 // details.
 //
+// 2026: elements are stored inline in their nodes.  See prioque.h.
+//
 
+#define _GNU_SOURCE // writer-preferring rwlocks
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include "prioque.h"
+#include "profile.h"
+
+// element storage starts this far into a node, rounded up so that any
+// element type stored inline is suitably aligned
+#define ELEMENT_OFFSET \
+  ((sizeof(struct _Queue_element) + sizeof(max_align_t) - 1) / \
+   sizeof(max_align_t) * sizeof(max_align_t))
 
 // global lock on entire package
 pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
 
-// for init purposes
+// registry of named queues, see register_queue()
+Queue *registered_queues = NULL;
+pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// for init purposes.  Queue locks prefer writers: the default glibc
+// rwlock prefers readers, so overlapping read cursors could keep a
+// writer waiting forever.
+#if defined(PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP)
+pthread_rwlock_t initial_lock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+#else
+pthread_rwlock_t initial_lock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
 pthread_mutex_t initial_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // function prototypes for internal functions
@@ -29,6 +51,19 @@ void nolock_add_to_queue(Queue *q, void *element, int priority);
 void *nolock_pointer_to_current(Queue *q);
 int nolock_current_priority(Queue *q);
 unsigned int nolock_end_of_queue(Queue *q);
+Queue_element nolock_new_element(Queue *q, void *element, int priority);
+unsigned int list_contains(Queue *q, Queue_element list, void *element);
+Queue_element merge_elements(Queue_element list1, Queue_element list2);
+Queue_element sort_elements(Queue_element list, unsigned long length);
+Queue_element last_element(Queue_element list);
+void nolock_join_elements(Queue *q, Queue_element list, Queue_element list_tail,
+			  unsigned long length, unsigned int list_sorted);
+void two_lock_append(Queue *q, Queue_element list, Queue_element list_tail,
+		     unsigned long length);
+unsigned long two_lock_remove(Queue *q, char *elements, unsigned long count);
+void check_not_two_lock(Queue *q, const char *function);
+void note_length(Queue *q);
+void unregister_queue(Queue *q);
 
 
 void init_queue(Queue *q, unsigned int elementsize, unsigned int duplicates,
@@ -41,21 +76,163 @@ void init_queue(Queue *q, unsigned int elementsize, unsigned int duplicates,
   q->duplicates = duplicates;
   q->compare = compare;
   q->priority_is_tag_only = priority_is_tag_only;
+  q->two_lock = FALSE;
+  q->peak_length = 0;
+  q->name = NULL;
+  q->next_registered = NULL;
   nolock_rewind_queue(q);
-  q->lock = initial_mutex;
+  q->lock = initial_lock;
+
+}
+
+
+void init_two_lock_queue(Queue *q, unsigned int elementsize) {
+
+  Queue_element dummy;
+
+  init_queue(q, elementsize, TRUE, NULL, TRUE);
+
+  dummy = (Queue_element) malloc(ELEMENT_OFFSET + elementsize);
+  PROFILE_COUNT_MALLOC();
+  if (dummy == NULL) {
+    fprintf(stderr, "malloc() failed in function init_two_lock_queue()\n");
+    exit(1);
+  }
+  dummy->info = (char *)dummy + ELEMENT_OFFSET;
+  dummy->priority = 0;
+  dummy->next = NULL;
+
+  // the head always points to a dummy node, the first element is the
+  // one after it
+  q->queue = dummy;
+  q->tail = dummy;
+  q->two_lock = TRUE;
+  q->head_lock = initial_mutex;
+  q->tail_lock = initial_mutex;
+}
+
+
+// records a new peak length of 'q'; called with the lock that
+// serializes adders held
 
+void note_length(Queue *q) {
+
+  unsigned long length = __atomic_load_n(&(q->queuelength), __ATOMIC_RELAXED);
+
+  if (length > q->peak_length) {
+    q->peak_length = length;
+  }
+}
+
+
+// only add/remove style functions know about the dummy node of
+// two-lock queues
+
+void check_not_two_lock(Queue *q, const char *function) {
+
+#if defined(CONSISTENCY_CHECKING)
+  if (q->two_lock) {
+    fprintf(stderr, "Function %s() is not supported on two-lock queues\n", function);
+    exit(1);
+  }
+#endif
+}
+
+
+// links a list of new elements behind the tail of a two-lock queue.
+// Only the tail lock is taken; the link is published with release
+// semantics because a remover may be reading the same 'next' field
+// when the queue is empty.
+
+void two_lock_append(Queue *q, Queue_element list, Queue_element list_tail,
+		     unsigned long length) {
+
+  if (list == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&(q->tail_lock));
+  PROFILE_COUNT_LOCK();
+
+  __atomic_store_n(&(q->tail->next), list, __ATOMIC_RELEASE);
+  q->tail = list_tail;
+  __atomic_add_fetch(&(q->queuelength), length, __ATOMIC_RELAXED);
+  note_length(q);
+
+  pthread_mutex_unlock(&(q->tail_lock));
+}
+
+
+// removes up to 'count' elements from a two-lock queue, taking only
+// the head lock.  The node of the last element removed becomes the new
+// dummy; the old dummies are freed after the lock is released.
+
+unsigned long two_lock_remove(Queue *q, char *elements, unsigned long count) {
+
+  Queue_element next, old_head, garbage = NULL;
+  unsigned long removed = 0;
+
+  pthread_mutex_lock(&(q->head_lock));
+  PROFILE_COUNT_LOCK();
+
+  while (removed < count &&
+	 (next = __atomic_load_n(&(q->queue->next), __ATOMIC_ACQUIRE)) != NULL) {
+    memcpy(elements, next->info, q->elementsize);
+    PROFILE_COUNT_COPY(q->elementsize);
+    elements += q->elementsize;
+    old_head = q->queue;
+    q->queue = next;
+    old_head->next = garbage;
+    garbage = old_head;
+    removed++;
+  }
+  if (removed > 0) {
+    __atomic_sub_fetch(&(q->queuelength), removed, __ATOMIC_RELAXED);
+  }
+
+  pthread_mutex_unlock(&(q->head_lock));
+
+  while (garbage != NULL) {
+    old_head = garbage;
+    garbage = garbage->next;
+    free(old_head);
+  }
+
+  return removed;
 }
 
 
 void destroy_queue(Queue *q) {
+  PROFILE_SCOPE(PHASE_DESTROY_QUEUE);
+
+  if (q->name != NULL) {
+    unregister_queue(q);
+  }
+
+  if (q->two_lock) {
+    pthread_mutex_lock(&(q->head_lock));
+    PROFILE_COUNT_LOCK();
+    pthread_mutex_lock(&(q->tail_lock));
+    PROFILE_COUNT_LOCK();
+
+    // the dummy node goes too
+    nolock_destroy_queue(q);
+    q->queuelength = 0;
+    q->tail = NULL;
+
+    pthread_mutex_unlock(&(q->tail_lock));
+    pthread_mutex_unlock(&(q->head_lock));
+    return;
+  }
 
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   nolock_destroy_queue(q);
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 }
 
 
@@ -65,7 +242,6 @@ void nolock_destroy_queue(Queue *q) {
 
   if (q != NULL) {
     while (q->queue != NULL) {
-      free(q->queue->info);
       temp = q->queue;
       q->queue = q->queue->next;
       free(temp);
@@ -80,13 +256,17 @@ void nolock_destroy_queue(Queue *q) {
 unsigned int element_in_queue(Queue *q, void *element) {
 
   unsigned int found;
+  PROFILE_SCOPE(PHASE_ELEMENT_IN_QUEUE);
+
+  check_not_two_lock(q, "element_in_queue");
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   found = nolock_element_in_queue(q, element);
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
   return found;
 }
@@ -127,22 +307,10 @@ void nolock_add_to_queue(Queue *q, void *element, int priority) {
   if (!q->queue ||
      (q->queue && (q->duplicates || !nolock_element_in_queue(q, element)))) {
 
-    new_element = (Queue_element) malloc(sizeof(struct _Queue_element));
-    if (new_element == NULL) {
-      fprintf(stderr, "malloc() failed in function add_to_queue()\n");
-      exit(1);
-    }
-    new_element->info = (void *)malloc(q->elementsize);
-    if (new_element->info == NULL) {
-      fprintf(stderr, "malloc() failed in function add_to_queue()\n");
-      exit(1);
-    }
-
-    memcpy(new_element->info, element, q->elementsize);
-
-    new_element->priority = priority;
+    new_element = nolock_new_element(q, element, priority);
 
     (q->queuelength)++;
+    note_length(q);
 
     if (q->queue == NULL) {             // first element
       new_element->next = NULL;
@@ -161,10 +329,9 @@ void nolock_add_to_queue(Queue *q, void *element, int priority) {
 	ptr = ptr->next;
       }
 
-      if (! prev) {   // queue only had one element and new element
-		      // has higher priority
+      if (! prev) {   // new element has higher priority than all
+		      // others, tail is unchanged
 	new_element->next=q->queue;
-	q->tail = q->queue;
 	q->queue=new_element;
       }
       else {         // insert new element 
@@ -192,28 +359,261 @@ void nolock_add_to_queue(Queue *q, void *element, int priority) {
 }
 
 
+// allocates a node holding a copy of 'element'; the node is not linked
+// into 'q'
+
+Queue_element nolock_new_element(Queue *q, void *element, int priority) {
+
+  Queue_element new_element;
+
+  // node and element share a single allocation
+  new_element = (Queue_element) malloc(ELEMENT_OFFSET + q->elementsize);
+  PROFILE_COUNT_MALLOC();
+  if (new_element == NULL) {
+    fprintf(stderr, "malloc() failed in function add_to_queue()\n");
+    exit(1);
+  }
+  new_element->info = (char *)new_element + ELEMENT_OFFSET;
+
+  memcpy(new_element->info, element, q->elementsize);
+  PROFILE_COUNT_COPY(q->elementsize);
+
+  new_element->priority = priority;
+  new_element->next = NULL;
+
+  return new_element;
+}
+
+
+// does the NULL-terminated 'list' contain 'element', according to
+// the 'compare' function of 'q'?
+
+unsigned int list_contains(Queue *q, Queue_element list, void *element) {
+
+  while (list != NULL) {
+    if (q->compare(element, list->info) == 0) {
+      return TRUE;
+    }
+    list = list->next;
+  }
+
+  return FALSE;
+}
+
+
+// merges two lists sorted by priority into one in a single pass.  The
+// merge is stable: among equal priorities, elements of 'list1' come
+// first, matching the strict add-to-rear rule of add_to_queue().
+
+Queue_element merge_elements(Queue_element list1, Queue_element list2) {
+
+  struct _Queue_element head;
+  Queue_element tail = &head;
+
+  while (list1 != NULL && list2 != NULL) {
+    if (list2->priority < list1->priority) {
+      tail->next = list2;
+      list2 = list2->next;
+    }
+    else {
+      tail->next = list1;
+      list1 = list1->next;
+    }
+    tail = tail->next;
+  }
+  tail->next = (list1 != NULL) ? list1 : list2;
+
+  return head.next;
+}
+
+
+// stable merge sort of a list of 'length' elements by priority
+
+Queue_element sort_elements(Queue_element list, unsigned long length) {
+
+  Queue_element second, prev = NULL;
+  unsigned long i;
+
+  if (length < 2) {
+    return list;
+  }
+
+  // split after the first half
+  second = list;
+  for (i = 0; i < length / 2; i++) {
+    prev = second;
+    second = second->next;
+  }
+  prev->next = NULL;
+
+  return merge_elements(sort_elements(list, length / 2),
+			sort_elements(second, length - length / 2));
+}
+
+
+Queue_element last_element(Queue_element list) {
+
+  while (list != NULL && list->next != NULL) {
+    list = list->next;
+  }
+
+  return list;
+}
+
+
+// links the NULL-terminated 'list' of 'length' elements into 'q' with
+// the same result as adding them one by one in list order, without
+// duplicate checks.  FIFO queues get the list appended in O(1);
+// priority queues get it merged in one pass, after a stable sort
+// unless 'list_sorted' says it is already ordered by priority.
+
+void nolock_join_elements(Queue *q, Queue_element list, Queue_element list_tail,
+			  unsigned long length, unsigned int list_sorted) {
+
+  Queue_element ptr;
+
+  if (list == NULL) {
+    return;
+  }
+
+  if (q->priority_is_tag_only) {      // FIFO queue, append
+    if (q->tail == NULL) {
+      q->queue = list;
+    }
+    else {
+      q->tail->next = list;
+    }
+    q->tail = list_tail;
+  }
+  else {                              // priority queue, one merge pass
+    if (! list_sorted) {
+      list_sorted = TRUE;
+      for (ptr = list; ptr->next != NULL && list_sorted; ptr = ptr->next) {
+	list_sorted = (ptr->priority <= ptr->next->priority);
+      }
+      if (! list_sorted) {
+	list = sort_elements(list, length);
+	list_tail = NULL;
+      }
+    }
+    if (q->tail != NULL && q->tail->priority <= list->priority) {
+      // whole list goes behind the current tail
+      q->tail->next = list;
+      q->tail = (list_tail != NULL) ? list_tail : last_element(list);
+    }
+    else {
+      q->queue = merge_elements(q->queue, list);
+      q->tail = last_element(q->tail != NULL ? q->tail : q->queue);
+    }
+  }
+  q->queuelength += length;
+  note_length(q);
+}
+
+
 void add_to_queue(Queue *q, void *element, int priority) {
 
+  Queue_element new_element;
+  PROFILE_SCOPE(PHASE_ADD_TO_QUEUE);
+
+  if (q->two_lock) {
+    new_element = nolock_new_element(q, element, priority);
+    two_lock_append(q, new_element, new_element, 1);
+    return;
+  }
+
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   nolock_add_to_queue(q, element, priority);
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
 }
 
 
+void add_batch_to_queue(Queue *q, void *elements, const int *priorities,
+			unsigned long count) {
+
+  Queue_element new_element, list = NULL, list_tail = NULL;
+  unsigned long length = 0, i;
+  char *element = (char *)elements;
+  PROFILE_SCOPE(PHASE_ADD_BATCH_TO_QUEUE);
+
+  if (q->two_lock) {
+    // build the list without holding any lock
+    for (i = 0; i < count; i++, element += q->elementsize) {
+      new_element = nolock_new_element(q, element, priorities ? priorities[i] : 0);
+      if (list_tail == NULL) {
+	list = new_element;
+      }
+      else {
+	list_tail->next = new_element;
+      }
+      list_tail = new_element;
+    }
+    two_lock_append(q, list, list_tail, count);
+    return;
+  }
+
+  // lock entire queue
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
+
+  if (! q->duplicates && ! q->compare) {
+    fprintf(stderr, "If duplicates are disallowed, the comparison function must be specified in init_queue().\n");
+    exit(1);
+  }
+
+  // build the batch as a list, dropping duplicates of queued elements
+  // or of elements earlier in the batch, which takes a walk of both
+  // lists per element
+  for (i = 0; i < count; i++, element += q->elementsize) {
+    if (q->duplicates ||
+	(! list_contains(q, q->queue, element) &&
+	 ! list_contains(q, list, element))) {
+      new_element = nolock_new_element(q, element, priorities ? priorities[i] : 0);
+      if (list_tail == NULL) {
+	list = new_element;
+      }
+      else {
+	list_tail->next = new_element;
+      }
+      list_tail = new_element;
+      length++;
+    }
+  }
+
+  nolock_join_elements(q, list, list_tail, length, FALSE);
+
+  nolock_rewind_queue(q);
+
+  // release lock on queue
+  pthread_rwlock_unlock(&(q->lock));
+}
+
+
 unsigned int empty_queue(Queue *q) {
 
   unsigned int ret;
+  PROFILE_SCOPE(PHASE_EMPTY_QUEUE);
+
+  if (q->two_lock) {
+    pthread_mutex_lock(&(q->head_lock));
+    PROFILE_COUNT_LOCK();
+    ret = (__atomic_load_n(&(q->queue->next), __ATOMIC_ACQUIRE) == NULL);
+    pthread_mutex_unlock(&(q->head_lock));
+    return ret;
+  }
   
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
   
   ret=(q->queue == NULL);
 
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
   return ret;
 }
@@ -224,9 +624,15 @@ void *remove_from_front(Queue *q, void *element) {
 
   Queue_element temp;
   void *ret=NULL;
+  PROFILE_SCOPE(PHASE_REMOVE_FROM_FRONT);
+
+  if (q->two_lock) {
+    return two_lock_remove(q, (char *)element, 1) ? element : NULL;
+  }
 
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   //  if (q->queue) {
   //    printf("BEFORE removal, queue %p contains:\n", q);
@@ -241,8 +647,8 @@ void *remove_from_front(Queue *q, void *element) {
 
   if (q->queue) {
     memcpy(element, q->queue->info, q->elementsize);
+    PROFILE_COUNT_COPY(q->elementsize);
     ret=element;
-    free(q->queue->info);
     temp = q->queue;
     q->queue = q->queue->next;
     free(temp);
@@ -269,42 +675,216 @@ void *remove_from_front(Queue *q, void *element) {
   
   
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
   return ret;
 }
 
 
+unsigned long remove_n_from_front(Queue *q, void *elements, unsigned long count) {
+
+  Queue_element temp;
+  unsigned long removed = 0;
+  char *element = (char *)elements;
+  PROFILE_SCOPE(PHASE_REMOVE_N_FROM_FRONT);
+
+  if (q->two_lock) {
+    return two_lock_remove(q, element, count);
+  }
+
+  // lock entire queue
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
+
+  while (q->queue && removed < count) {
+    memcpy(element, q->queue->info, q->elementsize);
+    PROFILE_COUNT_COPY(q->elementsize);
+    element += q->elementsize;
+    temp = q->queue;
+    q->queue = q->queue->next;
+    free(temp);
+    removed++;
+  }
+  q->queuelength -= removed;
+  if (q->queue == NULL || q->queue->next == NULL) {
+    // new tail
+    q->tail = q->queue;
+  }
+
+  nolock_rewind_queue(q);
+
+  // release lock on queue
+  pthread_rwlock_unlock(&(q->lock));
+
+  return removed;
+}
+
+
 void *peek_at_current(Queue *q, void *element) {
 
   void *ret=NULL;
 
-  // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  // read lock on queue
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   if (q->queue && q->current) {
     memcpy(element, (q->current)->info, q->elementsize);
+    PROFILE_COUNT_COPY(q->elementsize);
     ret=element;
   }
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
   return ret;
 }
 
 
+const void *peek_front(Queue *q, int *priority) {
+
+  const void *data=NULL;
+  Queue_element front;
+  PROFILE_SCOPE(PHASE_PEEK_FRONT);
+
+  if (q->two_lock) {
+    pthread_mutex_lock(&(q->head_lock));
+    PROFILE_COUNT_LOCK();
+    front = __atomic_load_n(&(q->queue->next), __ATOMIC_ACQUIRE);
+    if (front) {
+      data = front->info;
+      if (priority) {
+	*priority = front->priority;
+      }
+    }
+    pthread_mutex_unlock(&(q->head_lock));
+    return data;
+  }
+
+  // read lock on queue
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
+
+  if (q->queue) {
+    data = q->queue->info;
+    if (priority) {
+      *priority = q->queue->priority;
+    }
+  }
+
+  // release lock on queue
+  pthread_rwlock_unlock(&(q->lock));
+
+  return data;
+}
+
+
+void queue_memory(Queue *q, Queue_memory *m) {
+
+  unsigned long node_size = ELEMENT_OFFSET + q->elementsize;
+  unsigned long dummy = q->two_lock ? 1 : 0;
+
+  if (q->two_lock) {
+    pthread_mutex_lock(&(q->tail_lock));
+    PROFILE_COUNT_LOCK();
+  }
+  else {
+    // read lock on queue
+    pthread_rwlock_rdlock(&(q->lock));
+    PROFILE_COUNT_LOCK();
+  }
+
+  m->nodes = __atomic_load_n(&(q->queuelength), __ATOMIC_RELAXED) + dummy;
+  m->peak_nodes = q->peak_length + dummy;
+
+  if (q->two_lock) {
+    pthread_mutex_unlock(&(q->tail_lock));
+  }
+  else {
+    // release lock on queue
+    pthread_rwlock_unlock(&(q->lock));
+  }
+
+  m->bytes = m->nodes * node_size;
+  m->peak_bytes = m->peak_nodes * node_size;
+}
+
+
+void register_queue(Queue *q, const char *name) {
+
+  Queue **last;
+
+  pthread_mutex_lock(&registry_lock);
+
+  if (q->name == NULL) {
+    // append, so reports list queues in registration order
+    last = &registered_queues;
+    while (*last != NULL) {
+      last = &((*last)->next_registered);
+    }
+    q->next_registered = NULL;
+    *last = q;
+  }
+  q->name = name;
+
+  pthread_mutex_unlock(&registry_lock);
+}
+
+
+void unregister_queue(Queue *q) {
+
+  Queue **link;
+
+  pthread_mutex_lock(&registry_lock);
+
+  for (link = &registered_queues; *link != NULL; link = &((*link)->next_registered)) {
+    if (*link == q) {
+      *link = q->next_registered;
+      break;
+    }
+  }
+  q->name = NULL;
+  q->next_registered = NULL;
+
+  pthread_mutex_unlock(&registry_lock);
+}
+
+
+void print_queue_memory(FILE *out, const char *name, const Queue_memory *m) {
+
+  fprintf(out, "%-16s %10lu nodes %14lu bytes, peak %10lu nodes %14lu bytes\n",
+	  name, m->nodes, m->bytes, m->peak_nodes, m->peak_bytes);
+}
+
+
+void report_queue_memory(FILE *out) {
+
+  Queue_memory m;
+  Queue *q;
+
+  pthread_mutex_lock(&registry_lock);
+
+  for (q = registered_queues; q != NULL; q = q->next_registered) {
+    queue_memory(q, &m);
+    print_queue_memory(out, q->name, &m);
+  }
+
+  pthread_mutex_unlock(&registry_lock);
+}
+
+
 void *pointer_to_current(Queue *q) {
 
   void *data=NULL;
 
-  // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  // read lock on queue
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   data = nolock_pointer_to_current(q);
   
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
   return data;
 }
@@ -326,13 +906,14 @@ int current_priority(Queue *q) {
   
   int priority;
   
-  // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  // read lock on queue
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
   
   priority = nolock_current_priority(q);
   
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
   
   return priority;
 }
@@ -361,7 +942,8 @@ int nolock_current_priority(Queue *q) {
 void update_current(Queue *q, void *element) {
 
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
 #if defined(CONSISTENCY_CHECKING)
   if (q->queue == NULL || q->current == NULL) {
@@ -372,10 +954,11 @@ void update_current(Queue *q, void *element) {
 #endif
   {
     memcpy(q->current->info, element, q->elementsize);
+    PROFILE_COUNT_COPY(q->elementsize);
   }
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 }
 
 
@@ -385,7 +968,8 @@ void delete_current(Queue *q) {
   Queue_element temp;
 
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
 #if defined(CONSISTENCY_CHECKING)
   if (q->queue == NULL || q->current == NULL) {
@@ -396,7 +980,6 @@ void delete_current(Queue *q) {
 #endif
   {
 
-    free(q->current->info);
     temp = q->current;
 
     if (q->previous == NULL) {	// deletion at beginning
@@ -422,7 +1005,7 @@ void delete_current(Queue *q) {
   }
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
 }
 
@@ -437,11 +1020,12 @@ unsigned int end_of_queue(Queue *q) {
 
   unsigned int ret;
 
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   ret = nolock_end_of_queue(q);
 
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 
   return ret;
 }
@@ -450,12 +1034,13 @@ unsigned int end_of_queue(Queue *q) {
 void next_element(Queue *q) {
 
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   nolock_next_element(q);
 
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 }
 
 
@@ -483,13 +1068,16 @@ void nolock_next_element(Queue *q) {
 
 void rewind_queue(Queue *q) {
 
+  check_not_two_lock(q, "rewind_queue");
+
   // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  pthread_rwlock_wrlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
 
   nolock_rewind_queue(q);
   
   // release lock on queue
-  pthread_mutex_unlock(&(q->lock));
+  pthread_rwlock_unlock(&(q->lock));
 }
 
 
@@ -504,14 +1092,20 @@ void nolock_rewind_queue(Queue *q) {
 unsigned long queue_length(Queue *q) {
 
   unsigned long ret;
+  PROFILE_SCOPE(PHASE_QUEUE_LENGTH);
+
+  if (q->two_lock) {
+    return __atomic_load_n(&(q->queuelength), __ATOMIC_RELAXED);
+  }
   
-  // lock entire queue
-  pthread_mutex_lock(&(q->lock));
+  // read lock on queue
+  pthread_rwlock_rdlock(&(q->lock));
+  PROFILE_COUNT_LOCK();
   
   ret=q->queuelength;
   
-  // lock entire queue
-  pthread_mutex_unlock(&(q->lock));
+  // read lock on queue
+  pthread_rwlock_unlock(&(q->lock));
   
   return ret;
 }
@@ -519,13 +1113,27 @@ unsigned long queue_length(Queue *q) {
 
 void copy_queue(Queue *q1, Queue *q2) {
 
+  Queue_element temp, new_element;
+  PROFILE_SCOPE(PHASE_COPY_QUEUE);
+
+  check_not_two_lock(q1, "copy_queue");
+  check_not_two_lock(q2, "copy_queue");
+
+  // a queue is already a copy of itself
+  if (q1 == q2) {
+    return;
+  }
+
   // to avoid deadlock, this function acquires a global package
   // lock!
   pthread_mutex_lock(&global_lock);
+  PROFILE_COUNT_LOCK();
 
   // lock entire queues q1, q2
-  pthread_mutex_lock(&(q1->lock));
-  pthread_mutex_lock(&(q2->lock));
+  pthread_rwlock_wrlock(&(q1->lock));
+  PROFILE_COUNT_LOCK();
+  pthread_rwlock_wrlock(&(q2->lock));
+  PROFILE_COUNT_LOCK();
 
   // free elements in q1 before copy 
 
@@ -541,19 +1149,27 @@ void copy_queue(Queue *q1, Queue *q2) {
   q1->priority_is_tag_only = q2->priority_is_tag_only;
   q1->compare = q2->compare;
 
-  nolock_rewind_queue(q2);
-  while (! nolock_end_of_queue(q2)) {
-    nolock_add_to_queue(q1, nolock_pointer_to_current(q2), nolock_current_priority(q2));
-    nolock_next_element(q2);
+  // 'q2' is already ordered and free of duplicates, so a linear clone
+  // of its elements is enough
+  for (temp = q2->queue; temp != NULL; temp = temp->next) {
+    new_element = nolock_new_element(q1, temp->info, temp->priority);
+    if (q1->tail == NULL) {
+      q1->queue = new_element;
+    }
+    else {
+      q1->tail->next = new_element;
+    }
+    q1->tail = new_element;
+    (q1->queuelength)++;
   }
-     
+  note_length(q1);
 
   nolock_rewind_queue(q1);
   nolock_rewind_queue(q2);
   
   // release locks on q1, q2
-  pthread_mutex_unlock(&(q2->lock));
-  pthread_mutex_unlock(&(q1->lock));
+  pthread_rwlock_unlock(&(q2->lock));
+  pthread_rwlock_unlock(&(q1->lock));
 
   // release global package lock
   pthread_mutex_unlock(&global_lock);
@@ -567,13 +1183,23 @@ unsigned int equal_queues(Queue *q1, Queue *q2) {
   Queue_element temp1, temp2;
   unsigned int same = TRUE;
 
+  check_not_two_lock(q1, "equal_queues");
+  check_not_two_lock(q2, "equal_queues");
+
   // to avoid deadlock, this function acquires a global package
   // lock!
   pthread_mutex_lock(&global_lock);
-
-  // lock entire queues q1, q2
-  pthread_mutex_lock(&(q1->lock));
-  pthread_mutex_lock(&(q2->lock));
+  PROFILE_COUNT_LOCK();
+
+  // read locks on queues q1, q2; q1 is locked only once if it is
+  // also q2, since a writer-preferring lock must not be read locked
+  // twice by the same thread
+  pthread_rwlock_rdlock(&(q1->lock));
+  PROFILE_COUNT_LOCK();
+  if (q2 != q1) {
+    pthread_rwlock_rdlock(&(q2->lock));
+    PROFILE_COUNT_LOCK();
+  }
 
   if (q1->queuelength != q2->queuelength || q1->elementsize != q2->elementsize) {
     same = FALSE;
@@ -590,8 +1216,10 @@ unsigned int equal_queues(Queue *q1, Queue *q2) {
   }
 
   // release locks on q1, q2
-  pthread_mutex_unlock(&(q2->lock));
-  pthread_mutex_unlock(&(q1->lock));
+  if (q2 != q1) {
+    pthread_rwlock_unlock(&(q2->lock));
+  }
+  pthread_rwlock_unlock(&(q1->lock));
 
   // release global package lock
   pthread_mutex_unlock(&global_lock);
@@ -602,30 +1230,239 @@ unsigned int equal_queues(Queue *q1, Queue *q2) {
 
 void merge_queues(Queue *q1, Queue *q2) {
 
-  Queue_element temp;
+  Queue_element temp, new_element, added = NULL, added_tail = NULL;
+  unsigned long added_length = 0;
+  PROFILE_SCOPE(PHASE_MERGE_QUEUES);
+
+  check_not_two_lock(q1, "merge_queues");
+  check_not_two_lock(q2, "merge_queues");
 
   // to avoid deadlock, this function acquires a global package
   // lock!
   pthread_mutex_lock(&global_lock);
+  PROFILE_COUNT_LOCK();
+
+  // lock entire queue q1, read lock on q2 unless it is q1.  Merging a
+  // queue into itself is safe, the copies are only joined to q1 once
+  // all of q2 has been read
+  pthread_rwlock_wrlock(&(q1->lock));
+  PROFILE_COUNT_LOCK();
+  if (q2 != q1) {
+    pthread_rwlock_rdlock(&(q2->lock));
+    PROFILE_COUNT_LOCK();
+  }
+
+  if (! q1->duplicates && ! q1->compare) {
+    fprintf(stderr, "If duplicates are disallowed, the comparison function must be specified in init_queue().\n");
+    exit(1);
+  }
+
+  // copy the elements of q2, in order, dropping duplicates of elements
+  // in q1 or copied earlier.  'compare' only tells equal from unequal,
+  // so finding a duplicate takes a walk of both lists
+  for (temp = q2->queue; temp != NULL; temp = temp->next) {
+    if (q1->duplicates ||
+	(! list_contains(q1, q1->queue, temp->info) &&
+	 ! list_contains(q1, added, temp->info))) {
+      new_element = nolock_new_element(q1, temp->info, temp->priority);
+      if (added_tail == NULL) {
+	added = new_element;
+      }
+      else {
+	added_tail->next = new_element;
+      }
+      added_tail = new_element;
+      added_length++;
+    }
+  }
+
+  nolock_join_elements(q1, added, added_tail, added_length, ! q2->priority_is_tag_only);
+
+  nolock_rewind_queue(q1);
+
+  // release locks on q1, q2
+  if (q2 != q1) {
+    pthread_rwlock_unlock(&(q2->lock));
+  }
+  pthread_rwlock_unlock(&(q1->lock));
+
+  // release global package lock
+  pthread_mutex_unlock(&global_lock);
+
+}
+
+
+void splice_queues(Queue *q1, Queue *q2) {
+  PROFILE_SCOPE(PHASE_SPLICE_QUEUES);
+
+  check_not_two_lock(q1, "splice_queues");
+  check_not_two_lock(q2, "splice_queues");
+
+  // the elements of a queue are already in it
+  if (q1 == q2) {
+    return;
+  }
+
+  // to avoid deadlock, this function acquires a global package
+  // lock!
+  pthread_mutex_lock(&global_lock);
+  PROFILE_COUNT_LOCK();
 
   // lock entire queues q1, q2
-  pthread_mutex_lock(&(q1->lock));
-  pthread_mutex_lock(&(q2->lock));
+  pthread_rwlock_wrlock(&(q1->lock));
+  PROFILE_COUNT_LOCK();
+  pthread_rwlock_wrlock(&(q2->lock));
+  PROFILE_COUNT_LOCK();
+
+#if defined(CONSISTENCY_CHECKING)
+  if (q1->elementsize != q2->elementsize) {
+    fprintf(stderr, "Element sizes differ in function splice_queues()\n");
+    exit(1);
+  }
+#endif
 
-  temp = q2->queue;
+  if (q2->queue != NULL) {
+    nolock_join_elements(q1, q2->queue, q2->tail, q2->queuelength,
+			 ! q2->priority_is_tag_only);
 
-  while (temp != NULL) {
-    nolock_add_to_queue(q1, temp->info, temp->priority);
-    temp = temp->next;
+    q2->queue = NULL;
+    q2->tail = NULL;
+    q2->queuelength = 0;
   }
 
   nolock_rewind_queue(q1);
+  nolock_rewind_queue(q2);
 
   // release locks on q1, q2
-  pthread_mutex_unlock(&(q2->lock));
-  pthread_mutex_unlock(&(q1->lock));
+  pthread_rwlock_unlock(&(q2->lock));
+  pthread_rwlock_unlock(&(q1->lock));
 
   // release global package lock
   pthread_mutex_unlock(&global_lock);
 
 }
+
+
+void open_cursor(Queue *q, Queue_cursor *c, unsigned int for_update) {
+
+  check_not_two_lock(q, "open_cursor");
+
+  if (for_update) {
+    pthread_rwlock_wrlock(&(q->lock));
+    PROFILE_COUNT_LOCK();
+  }
+  else {
+    pthread_rwlock_rdlock(&(q->lock));
+    PROFILE_COUNT_LOCK();
+  }
+
+  c->q = q;
+  c->for_update = for_update;
+  c->current = q->queue;
+  c->previous = NULL;
+}
+
+
+void close_cursor(Queue_cursor *c) {
+
+  pthread_rwlock_unlock(&(c->q->lock));
+
+  c->q = NULL;
+  c->current = NULL;
+  c->previous = NULL;
+}
+
+
+void cursor_rewind(Queue_cursor *c) {
+
+  c->current = c->q->queue;
+  c->previous = NULL;
+}
+
+
+void cursor_next(Queue_cursor *c) {
+
+#if defined(CONSISTENCY_CHECKING)
+  if (c->current == NULL) {
+    fprintf(stderr,
+	    "Advance past end--NULL pointer in function cursor_next()\n");
+    exit(1);
+  }
+  else
+#endif
+  {
+    c->previous = c->current;
+    c->current = c->current->next;
+  }
+}
+
+
+unsigned int cursor_at_end(Queue_cursor *c) {
+
+  return (c->current == NULL);
+}
+
+
+const void *cursor_element(Queue_cursor *c) {
+
+  return c->current ? c->current->info : NULL;
+}
+
+
+int cursor_priority(Queue_cursor *c) {
+
+#if defined(CONSISTENCY_CHECKING)
+  if (c->current == NULL) {
+    fprintf(stderr, "NULL pointer in function cursor_priority()\n");
+    exit(1);
+  }
+#endif
+
+  return c->current->priority;
+}
+
+
+void cursor_update(Queue_cursor *c, void *element) {
+
+#if defined(CONSISTENCY_CHECKING)
+  if (c->current == NULL || ! c->for_update) {
+    fprintf(stderr, "NULL pointer or read cursor in function cursor_update()\n");
+    exit(1);
+  }
+#endif
+
+  memcpy(c->current->info, element, c->q->elementsize);
+  PROFILE_COUNT_COPY(c->q->elementsize);
+}
+
+
+void cursor_delete(Queue_cursor *c) {
+
+  Queue *q = c->q;
+  Queue_element temp = c->current;
+
+#if defined(CONSISTENCY_CHECKING)
+  if (c->current == NULL || ! c->for_update) {
+    fprintf(stderr, "NULL pointer or read cursor in function cursor_delete()\n");
+    exit(1);
+  }
+#endif
+
+  if (c->previous == NULL) {	// deletion at beginning
+    q->queue = temp->next;
+  }
+  else {			// internal deletion
+    c->previous->next = temp->next;
+  }
+  if (q->tail == temp) {
+    q->tail = c->previous;
+  }
+  c->current = temp->next;
+
+  free(temp);
+  (q->queuelength)--;
+
+  // the global position may have referred to the deleted element
+  nolock_rewind_queue(q);
+}
+
@@ -44,10 +44,35 @@
 // longer used in any production code that I'm aware of.  Rewrote
 // copy_queue().
 //
+// October 2026: elements are now stored inline, directly behind their
+// Queue_element node, so adding an element costs one malloc() instead
+// of two and removing it one free().  The 'info' field still points
+// to the element, so code reading it is unaffected.  Added
+// peek_front() for zero-copy inspection of the front element.
+// merge_queues() (unless the target disallows duplicates) and
+// copy_queue() now run in linear time and the new splice_queues()
+// moves the elements of one queue into another without copying
+// them.  Added add_batch_to_queue() and remove_n_from_front()
+// to move many elements while taking the queue lock once.  The queue
+// lock is now a reader-writer lock, so functions that only look at a
+// queue no longer exclude each other, and cursors (SECTION 3) give
+// every walker its own position instead of the shared current
+// position.  Added two-lock FIFO queues (init_two_lock_queue()) where
+// adding and removing elements proceed in parallel.  Building with
+// -DPROFILING (and profile.c) times the entry points and counts lock
+// acquisitions, mallocs and copied bytes, see profile.h.  Every queue
+// now tracks its peak length, queue_memory() reports the bytes its
+// nodes hold now and at the peak, and queues given a name with
+// register_queue() can all be reported by report_queue_memory().
+// Queue locks prefer writers where the C library allows it, so a
+// steady stream of read cursors cannot starve a thread waiting to
+// update the queue.
+//
 
 #if ! defined(QUEUE_TYPE_DEFINED)
 #define QUEUE_TYPE_DEFINED
 
+#include <stdio.h>
 #include <pthread.h>
 
 #define  TRUE  1
@@ -74,11 +99,35 @@ typedef struct Queue {
   unsigned int elementsize;	                     // 'sizeof()' one element 
   unsigned int duplicates;	                     // are duplicates allowed? 
   int (*compare) (const void *e1, const void *e2);   // element comparision function 
-  pthread_mutex_t lock;
+  pthread_rwlock_t lock;                              // readers share, writers are exclusive
   int priority_is_tag_only;                          // if TRUE, ignore priority and use
                                                      // strict FIFO
+  unsigned int two_lock;                             // TRUE for a two-lock FIFO queue
+  pthread_mutex_t head_lock;                         // two-lock FIFO: taken by removers
+  pthread_mutex_t tail_lock;                         // two-lock FIFO: taken by adders
+  unsigned long peak_length;                         // largest queuelength so far
+  const char *name;                                  // name given by register_queue()
+  struct Queue *next_registered;                     // next queue in the registry
 } Queue;
 
+// memory held by a queue, see queue_memory()
+
+typedef struct Queue_memory {
+  unsigned long nodes;                               // nodes allocated now
+  unsigned long bytes;                               // bytes requested for them
+  unsigned long peak_nodes;                          // most nodes allocated at once
+  unsigned long peak_bytes;                          // bytes requested for those
+} Queue_memory;
+
+// independent position in a queue, see SECTION 3
+
+typedef struct Queue_cursor {
+  Queue *q;                                          // queue being walked
+  Queue_element current;                             // current position
+  Queue_element previous;                            // one step back from current
+  unsigned int for_update;                           // holds the write lock?
+} Queue_cursor;
+
 
 //********
 //
@@ -112,6 +161,21 @@ void init_queue(Queue *q, unsigned int elementsize, unsigned int duplicates,
 		 unsigned int priority_is_tag_only);
 
 
+/* initializes a new two-lock FIFO queue 'q' with elements of size
+   'elementsize' (Michael & Scott's two-lock queue).  The queue keeps
+   a dummy node at its head; adders take only a tail lock and removers
+   only a head lock, so one thread can add while another removes.
+   Duplicates are allowed and priorities are tags only.
+
+   Only add_to_queue(), add_batch_to_queue(), remove_from_front(),
+   remove_n_from_front(), peek_front(), empty_queue(), queue_length()
+   and destroy_queue() may be used on a two-lock queue.  The other
+   functions report an error.  destroy_queue() also frees the dummy
+   node, so the queue must be initialized again before reuse.
+*/
+void init_two_lock_queue(Queue *q, unsigned int elementsize);
+
+
 /* destroys all elements in 'q'
 */
 void destroy_queue(Queue *q);
@@ -127,12 +191,35 @@ void destroy_queue(Queue *q);
 void add_to_queue(Queue *q, void *element, int priority);
 
 
+/* adds the 'count' elements stored contiguously in 'elements' to 'q',
+   with priorities taken from 'priorities' (or 0 for every element if
+   'priorities' is NULL).  The result is the same as calling
+   add_to_queue() for each element in order, but the queue is locked
+   once and, for priority queues, the batch is stably sorted and merged
+   into the queue in a single pass.  If 'q' disallows duplicates, each
+   element is still compared with every queued element and every
+   element before it in the batch, as add_to_queue() would, so the
+   batch takes O(count*(n+count)) time.
+*/
+void add_batch_to_queue(Queue *q, void *elements, const int *priorities,
+			unsigned long count);
+
+
 /* removes the element at the front of the 'q' and places it in 'element'. 
    If the queue is empty, returns NULL, otherwise a non-NULL value.
 */
 void *remove_from_front(Queue *q, void *element);
 
 
+/* removes up to 'count' elements from the front of the 'q', in order,
+   and places them contiguously in 'elements', which must have room
+   for 'count' elements.  The queue is locked once.  Returns the
+   number of elements removed, which is less than 'count' only if the
+   queue ran empty.
+*/
+unsigned long remove_n_from_front(Queue *q, void *elements, unsigned long count);
+
+
 /* returns TRUE if the 'element' exists in the 'q', otherwise false.
    The 'compare' function is used for matching.  As a side-effect, the
    current position in the queue is set to matching element, so
@@ -153,7 +240,9 @@ unsigned int empty_queue(Queue *q);
 unsigned long queue_length(Queue *q);
 
 
-/* makes a copy of 'q2' into 'q1'.  'q2' is not modified.
+/* makes a copy of 'q2' into 'q1'.  'q2' is not modified.  Runs in
+   time linear in the length of 'q2'.  Copying a queue into itself
+   leaves it unchanged.
 */
 void copy_queue(Queue *q1, Queue *q2);
 
@@ -161,16 +250,77 @@ void copy_queue(Queue *q1, Queue *q2);
 /* determines if 'q1' and 'q2' are equivalent.  Uses the 'compare'
    function of the first queue, which should match the 'compare' for
    the second!  Returns TRUE if the queues are equal, otherwise
-   returns FALSE.
+   returns FALSE.  A queue is equal to itself.
 */
 unsigned int equal_queues(Queue *q1, Queue *q2);
 
 
-/* merge 'q2' into 'q1'.   'q2' is not modified.
+/* merge 'q2' into 'q1'.   'q2' is not modified.  The result is the
+   same as adding the elements of 'q2' to 'q1' one by one in order,
+   but the merge is done in a single O(n+m) pass (plus a stable sort
+   if 'q2' is a FIFO queue and 'q1' is not).  If 'q1' disallows
+   duplicates, each element of 'q2' is still compared with every
+   element of 'q1' and every element copied before it, since
+   'compare' only tells whether two elements match: the merge then
+   takes O(m*(n+m)) time.  'q1' and 'q2' may be the same queue.
 */
 void merge_queues(Queue *q1, Queue *q2);
 
 
+/* moves every element of 'q2' into 'q1', leaving 'q2' empty.  No
+   elements are copied or allocated.  If 'q1' is a FIFO queue, the
+   elements of 'q2' are appended in O(1); otherwise they are merged in
+   a single stable pass.  Duplicate detection is NOT performed, so the
+   caller must ensure the queues are disjoint if 'q1' disallows
+   duplicates.  Both queues must have the same element size.
+   Splicing a queue into itself leaves it unchanged.
+*/
+void splice_queues(Queue *q1, Queue *q2);
+
+
+/* returns a pointer to the element at the front of 'q' without copying
+   it, and stores the element's priority in 'priority' unless
+   'priority' is NULL.  Returns NULL if the queue is empty.  The
+   current position is not modified.
+
+   Lock discipline: the pointer refers to storage owned by the queue
+   and is only valid until the front element is removed, updated or
+   the queue is destroyed.  The caller must either be the only thread
+   removing elements from 'q' or serialize removals itself while it
+   uses the pointer.  The element must not be modified through it.
+*/
+const void *peek_front(Queue *q, int *priority);
+
+
+/* stores the memory held by the nodes of 'q' in 'm': the nodes
+   allocated now and at the queue's peak length, and the bytes
+   requested from malloc() for them (each node holds its element
+   inline, allocator overhead is not included).  Two-lock queues count
+   their dummy node.
+*/
+void queue_memory(Queue *q, Queue_memory *m);
+
+
+/* adds 'q' to the registry of queues reported by
+   report_queue_memory() under 'name', which must stay valid while the
+   queue is registered.  destroy_queue() removes it again.
+*/
+void register_queue(Queue *q, const char *name);
+
+
+/* writes one line per registered queue, in registration order, with
+   its current and peak memory to 'out'
+*/
+void report_queue_memory(FILE *out);
+
+
+/* writes the memory line of 'm' under 'name' to 'out', in the format
+   of report_queue_memory(), so other containers can be listed with
+   the queues
+*/
+void print_queue_memory(FILE *out, const char *name, const Queue_memory *m);
+
+
 ////////////////////////////
 // SECTION 2
 ////////////////////////////
@@ -223,6 +373,75 @@ void delete_current (Queue *q);
 */
 unsigned int end_of_queue (Queue *q);
 
+
+////////////////////////////
+// SECTION 3
+////////////////////////////
+
+/* cursors walk a queue like the SECTION 2 functions, but each cursor
+   keeps its own position, so walks neither disturb nor are disturbed
+   by the global current position or by other cursors.
+
+   A read cursor holds the queue's read lock from open_cursor() to
+   close_cursor(): any number of read cursors (e.g. in monitoring
+   threads) can scan a queue at the same time, and only writers wait
+   for them.  An update cursor holds the write lock and may also
+   update or delete elements.  While a thread has a cursor open on a
+   queue it must not call any other function on that queue, and
+   cursors should be closed promptly since they block writers.
+
+   Queue locks prefer writers: once a writer waits, new read cursors
+   wait behind it, so overlapping monitoring scans cannot keep the
+   thread that updates the queue out.  In turn a thread must never
+   open a second read cursor on a queue it is already reading, since a
+   writer arriving in between would deadlock it.
+*/
+
+/********************/
+/********************/
+
+/* open cursor 'c' on 'q', positioned at the first element.  If
+   'for_update' is TRUE, the cursor may modify the queue. */
+void open_cursor (Queue *q, Queue_cursor *c, unsigned int for_update);
+
+
+/* close cursor 'c', releasing its lock on the queue */
+void close_cursor (Queue_cursor *c);
+
+
+/* move cursor 'c' to the first element */
+void cursor_rewind (Queue_cursor *c);
+
+
+/* move cursor 'c' to the next element */
+void cursor_next (Queue_cursor *c);
+
+
+/* has cursor 'c' moved beyond the last valid element?  Returns TRUE
+   if so, FALSE otherwise. */
+unsigned int cursor_at_end (Queue_cursor *c);
+
+
+/* return a pointer to the element at the position of cursor 'c', or
+   NULL if the cursor is at the end.  The pointer is valid until the
+   cursor is closed. */
+const void *cursor_element (Queue_cursor *c);
+
+
+/* return priority of the element at the position of cursor 'c' */
+int cursor_priority (Queue_cursor *c);
+
+
+/* update the element at the position of update cursor 'c'.  The
+   priority should not be changed by this function! */
+void cursor_update (Queue_cursor *c, void *element);
+
+
+/* delete the element at the position of update cursor 'c'; the cursor
+   moves to the following element.  The global current position of
+   the queue is rewound. */
+void cursor_delete (Queue_cursor *c);
+
 #endif
 
 
@@ -231,15 +450,25 @@ unsigned int end_of_queue (Queue *q);
 // SECTION 1
 void init_queue(Queue *q, int elementsize, int duplicates, 
 		int (*compare)(void *e1, void *e2), int priority_is_tag_only);
+void init_two_lock_queue(Queue *q, unsigned int elementsize);
 void destroy_queue(Queue *q);
 void add_to_queue(Queue *q, void *element, int priority);
+void add_batch_to_queue(Queue *q, void *elements, const int *priorities,
+			unsigned long count);
 void remove_from_front(Queue *q, void *element);
+unsigned long remove_n_from_front(Queue *q, void *elements, unsigned long count);
 unsigned int element_in_queue(Queue *q, void *element);
 unsigned int empty_queue(Queue *q);
 unsigned int queue_length(Queue *q);
 void copy_queue(Queue *q1, Queue *q2);
 unsigned int equal_queues(Queue q1, Queue *q2);
 void merge_queues(Queue *q1, Queue *q2);
+void splice_queues(Queue *q1, Queue *q2);
+const void *peek_front(Queue *q, int *priority);
+void queue_memory(Queue *q, Queue_memory *m);
+void register_queue(Queue *q, const char *name);
+void report_queue_memory(FILE *out);
+void print_queue_memory(FILE *out, const char *name, const Queue_memory *m);
 
 // SECTION 2
 
@@ -252,4 +481,16 @@ int current_priority(Queue *q);
 void delete_current(Queue *q);
 unsigned int end_of_queue(Queue *q);
 
+// SECTION 3
+
+void open_cursor(Queue *q, Queue_cursor *c, unsigned int for_update);
+void close_cursor(Queue_cursor *c);
+void cursor_rewind(Queue_cursor *c);
+void cursor_next(Queue_cursor *c);
+unsigned int cursor_at_end(Queue_cursor *c);
+const void *cursor_element(Queue_cursor *c);
+int cursor_priority(Queue_cursor *c);
+void cursor_update(Queue_cursor *c, void *element);
+void cursor_delete(Queue_cursor *c);
+
  *** QUICK REFERENCE ***/
@@ -0,0 +1,189 @@
+/* prioque_test: checks the prioque functions that take two queues
+   when they are given the same queue for both, which must neither
+   deadlock nor leave the queue's lock held or over-released, and
+   merging and batch adding into a queue that disallows duplicates.
+
+   usage: prioque_test
+
+   build: gcc -Wall prioque_test.c prioque.c -lpthread -o prioque_test
+
+   Prints every failed check and exits with status 1 if there was one,
+   otherwise prints "prioque_test: OK".
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "prioque.h"
+
+static unsigned int failures = 0;
+
+static void check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static int compare_ints(const void *e1, const void *e2)
+{
+    return *(const int *)e1 != *(const int *)e2;
+}
+
+// fills 'q' with 'count' elements 0, 1, ... with priority equal to the element
+static void fill_queue(Queue *q, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        add_to_queue(q, &i, i);
+}
+
+// is the lock of 'q' free, neither held by this thread nor released once too often?
+static int lock_is_free(Queue *q, const char *what)
+{
+    int element = -1;
+
+    if (pthread_rwlock_trywrlock(&(q->lock)) != 0)
+    {
+        printf("%s: the queue lock is still held\n", what);
+        return FALSE;
+    }
+    pthread_rwlock_unlock(&(q->lock));
+
+    // an over-released lock lets the write lock be taken, but its reader
+    // count is off and the next writer waits forever: trylock again
+    if (pthread_rwlock_trywrlock(&(q->lock)) != 0)
+    {
+        printf("%s: the queue lock was released twice\n", what);
+        return FALSE;
+    }
+    pthread_rwlock_unlock(&(q->lock));
+
+    add_to_queue(q, &element, -1);
+    remove_from_front(q, &element);
+    return element == -1;
+}
+
+static void test_same_queue(unsigned int duplicates)
+{
+    Queue q;
+    int element;
+
+    init_queue(&q, sizeof(int), duplicates, compare_ints, FALSE);
+    fill_queue(&q, 5);
+
+    check(equal_queues(&q, &q), "equal_queues(q, q) is TRUE");
+    check(lock_is_free(&q, "equal_queues(q, q)"), "equal_queues(q, q) releases the lock once");
+
+    copy_queue(&q, &q);
+    check(queue_length(&q) == 5, "copy_queue(q, q) leaves q unchanged");
+    check(lock_is_free(&q, "copy_queue(q, q)"), "copy_queue(q, q) releases the lock");
+
+    splice_queues(&q, &q);
+    check(queue_length(&q) == 5, "splice_queues(q, q) leaves q unchanged");
+    check(lock_is_free(&q, "splice_queues(q, q)"), "splice_queues(q, q) releases the lock");
+
+    merge_queues(&q, &q);
+    check(queue_length(&q) == (duplicates ? 10 : 5), "merge_queues(q, q) adds q once if duplicates are allowed");
+    check(lock_is_free(&q, "merge_queues(q, q)"), "merge_queues(q, q) releases the lock");
+
+    // the merged queue is still ordered by priority
+    for (element = 0; element < 5; element++)
+    {
+        int front;
+
+        remove_from_front(&q, &front);
+        check(front == element, "merge_queues(q, q) keeps q ordered");
+        if (duplicates)
+        {
+            remove_from_front(&q, &front);
+            check(front == element, "merge_queues(q, q) keeps q ordered");
+        }
+    }
+    check(empty_queue(&q), "merge_queues(q, q) adds no other elements");
+
+    destroy_queue(&q);
+}
+
+// merges a priority queue and a FIFO queue into duplicate-free priority queues
+static void test_merge_without_duplicates(void)
+{
+    Queue target, source, fifo;
+    int elements[] = {3, 7, 1, 7, 5, 9, 3};
+    int expected[] = {0, 1, 2, 3, 4, 5, 7, 9};
+    int element, i, ordered = TRUE;
+
+    init_queue(&target, sizeof(int), FALSE, compare_ints, FALSE);
+    init_queue(&source, sizeof(int), TRUE, compare_ints, FALSE);
+    init_queue(&fifo, sizeof(int), TRUE, compare_ints, TRUE);
+    fill_queue(&target, 5);
+    for (i = 0; i < 7; i++)
+    {
+        add_to_queue(&source, &elements[i], elements[i]);
+        add_to_queue(&fifo, &elements[i], elements[i]);
+    }
+
+    // 3 and 1 are in the target already, 7 and 3 appear twice in the source
+    merge_queues(&target, &source);
+    check(queue_length(&target) == 8, "merge_queues() drops elements already in the target");
+    check(queue_length(&source) == 7, "merge_queues() leaves the source unchanged");
+    for (i = 0; i < 8; i++)
+    {
+        remove_from_front(&target, &element);
+        ordered = ordered && element == expected[i];
+    }
+    check(ordered, "merge_queues() keeps one of each element, ordered by priority");
+
+    // the same elements from a FIFO source are sorted on the way in
+    fill_queue(&target, 5);
+    merge_queues(&target, &fifo);
+    check(queue_length(&target) == 8, "merge_queues() from a FIFO queue drops duplicates");
+    for (i = 0, ordered = TRUE; i < 8; i++)
+    {
+        remove_from_front(&target, &element);
+        ordered = ordered && element == expected[i];
+    }
+    check(ordered, "merge_queues() from a FIFO queue orders by priority");
+
+    destroy_queue(&target);
+    destroy_queue(&source);
+    destroy_queue(&fifo);
+}
+
+// adds a batch with repeated and already queued elements to a duplicate-free queue
+static void test_batch_without_duplicates(void)
+{
+    Queue q;
+    int elements[] = {3, 7, 1, 7, 5, 9, 3};
+    int expected[] = {0, 1, 2, 3, 4, 5, 7, 9};
+    int element, i, ordered = TRUE;
+
+    init_queue(&q, sizeof(int), FALSE, compare_ints, FALSE);
+    fill_queue(&q, 5);
+    add_batch_to_queue(&q, elements, elements, 7);
+    check(queue_length(&q) == 8, "add_batch_to_queue() drops duplicates");
+    for (i = 0; i < 8; i++)
+    {
+        remove_from_front(&q, &element);
+        ordered = ordered && element == expected[i];
+    }
+    check(ordered, "add_batch_to_queue() keeps one of each element, ordered by priority");
+    destroy_queue(&q);
+}
+
+int main(void)
+{
+    test_same_queue(TRUE);
+    test_same_queue(FALSE);
+    test_merge_without_duplicates();
+    test_batch_without_duplicates();
+
+    if (failures > 0)
+    {
+        printf("prioque_test: %u checks failed\n", failures);
+        return 1;
+    }
+    printf("prioque_test: OK\n");
+    return 0;
+}
@@ -50,17 +50,8 @@ int do_IO(Process *p)
             p->IOTime = p->saveIOTime;
         else
         {
-            // when there more behaviors, dequeue and populate the process  fields
-            if (!empty_queue(&(p->Behaviors)))
-            {
-                ProcessBehavior behavior;
-                remove_from_front(&(p->Behaviors), &behavior);
-                p->CPUTime = behavior.CPUBurst;
-                p->saveCPUTime = p->CPUTime;
-                p->IOTime = behavior.IOBurst;
-                p->saveIOTime = p->IOTime;
-                p->repeat = behavior.repeat;
-            }
+            // when there more behaviors, populate the process fields with the next one
+            load_next_behavior(p);
         }
         return FINISH;
     }
@@ -68,6 +59,22 @@ int do_IO(Process *p)
         return NOT_FINISH;
 }
 
+int load_next_behavior(Process *p)
+{
+    const ProcessBehavior *behavior;
+
+    if (p->program == NULL || p->nextBehavior >= p->program->length)
+        return FALSE;
+
+    behavior = &(p->program->behaviors[p->nextBehavior++]);
+    p->CPUTime = behavior->CPUBurst;
+    p->saveCPUTime = p->CPUTime;
+    p->IOTime = behavior->IOBurst;
+    p->saveIOTime = p->IOTime;
+    p->repeat = behavior->repeat;
+    return TRUE;
+}
+
 void init_process(Process *p)
 {
     p->CPU_Usage = 0;
@@ -76,5 +83,20 @@ void init_process(Process *p)
     p->promoteFactor = 3;
     p->demoteFactor = 1;
     p->quantum = 10;
-    init_queue(&(p->Behaviors), sizeof(ProcessBehavior), TRUE, NULL, TRUE);
-}
\ No newline at end of file
+    p->boostEpoch = 0;
+    p->readyTime = 0;
+    p->program = NULL;
+    p->nextBehavior = 0;
+    p->relativeDeadline = 0;
+    p->period = 0;
+    p->deadline = 0;
+    p->workingSet = 0;
+    p->lastRunTime = 0;
+}
+
+void release_process(Process *p)
+{
+    release_behavior_program(p->program);
+    p->program = NULL;
+    p->nextBehavior = 0;
+}
@@ -1,3 +1,18 @@
+#if !defined(PROCESS_TYPE_DEFINED)
+#define PROCESS_TYPE_DEFINED
+
+#include "behavior.h"
+
+/* Process lifecycle and ownership:
+   o init_process() gives a process no resources, it is safe to call on
+     any temporary.
+   o a process owns one reference to its program.  Copying a Process by
+     value (into or out of a queue) moves that ownership, so exactly one
+     copy of a live process may exist outside of dead temporaries.
+   o release_process() must be called on the copy that owns the program
+     once the process finished.
+*/
+
 #define DO_IO 0
 #define NOT_FINISH 1
 #define FINISH 2
@@ -13,21 +28,21 @@ typedef struct Process
     long unsigned int saveIOTime; // The IO time needed when finish IO but not finish repeating
     unsigned int repeat; // Numvber of times the process repeats for a behaviors
     unsigned int CPU_Usage; // Used to report CPU usage
-    unsigned int priority; //priority when enter the MLFQA, 1 highest , 2 , 3 lowest
+    unsigned int priority; //priority when enter the MLFQA, 1 highest , 2 , 3 lowest, 0 for the real-time class
     unsigned int promoteFactor; // promote factor, when 0 get promoted then reset, decrease by 1 when execute without exhausting quantum, initial with max value 3
     unsigned int demoteFactor; // demote factor, when 0 get demoted then reset, decrease by 1 when exhaust the quantum without IO or finish, initial with value 1, max is 3
     unsigned int quantum;
-    Queue Behaviors; //FIFO queue holds the behaviors of the process
+    unsigned int boostEpoch; // boost epoch the process was last stamped with, older epochs mean a pending priority boost
+    unsigned int readyTime; // time the process last entered a level queue, used for starvation reporting
+    const BehaviorProgram *program; // shared, interned behaviors of the process
+    unsigned long nextBehavior; // index in program of the next behavior to load
+    unsigned long relativeDeadline; // ticks a CPU burst may take from becoming ready to finishing, 0 if not real-time
+    unsigned long period; // minimum ticks between two CPU bursts becoming ready, used for admission control
+    unsigned long deadline; // absolute deadline of the current CPU burst of a real-time process
+    unsigned long workingSet; // ticks it takes to reload the working set of the process into a cold cache
+    unsigned int lastRunTime; // last tick the process executed, meaningless while CPU_Usage is 0
 } Process;
 
-// Struct of a behavior of a process
-typedef struct ProcessBehavior
-{
-    long unsigned int CPUBurst;
-    long unsigned int IOBurst;
-    unsigned int repeat;
-} ProcessBehavior;
-
 /* compare 2 processes by their PID,
    if PIDs are the same, they are the same process, return 0,
    otherwise return 1
@@ -48,6 +63,12 @@ int exec_process(Process *p);
 */
 int do_IO(Process *p);
 
+/* populates the CPU and IO fields of the process with the next behavior
+   of its program and advances the cursor.
+   return FALSE when the program has no more behaviors, TRUE otherwise
+*/
+int load_next_behavior(Process *p);
+
 /* initializes a process with following default values:
    PID = 0, indicate the <<null>> process
    CPU_usage = 0
@@ -55,5 +76,15 @@ int do_IO(Process *p);
    promoteFactor = 3
    demoteFactor = 1
    quantum = 10
+   boostEpoch = 0
+   program = NULL, no behaviors
+   workingSet = 0, no cache warmup cost
 */
-void init_process(Process *p);
\ No newline at end of file
+void init_process(Process *p);
+
+/* releases the resources owned by the process, its program reference,
+   and resets the program cursor.  The process must not run afterwards.
+*/
+void release_process(Process *p);
+
+#endif
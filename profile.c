@@ -0,0 +1,80 @@
+#include "profile.h"
+
+#if defined(PROFILING)
+
+#include <stdio.h>
+#include <time.h>
+
+#define PROFILE_MAX_DEPTH 8
+
+// Per-phase figures, inclusive of nested phases
+typedef struct PhaseProfile
+{
+    unsigned long calls;
+    unsigned long nanoseconds;
+    unsigned long counters[PROFILE_COUNTERS];
+} PhaseProfile;
+
+static const char *phaseNames[PROFILE_PHASES] = {
+    "load trace", "queue_new_arrivals", "execute_highest_priority", "do_io_for_processes",
+    "add_to_queue", "add_batch_to_queue", "remove_from_front", "remove_n_from_front",
+    "peek_front", "empty_queue", "queue_length", "element_in_queue",
+    "copy_queue", "merge_queues", "splice_queues", "destroy_queue"};
+
+// each thread profiles itself, so no synchronization is needed
+static __thread PhaseProfile phases[PROFILE_PHASES];
+static __thread int activePhases[PROFILE_MAX_DEPTH];
+static __thread unsigned long startTimes[PROFILE_MAX_DEPTH];
+static __thread int depth = 0;
+
+static unsigned long now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+int profile_begin(int phase)
+{
+    if (depth < PROFILE_MAX_DEPTH)
+    {
+        activePhases[depth] = phase;
+        startTimes[depth] = now();
+    }
+    depth++;
+    phases[phase].calls++;
+    return phase;
+}
+
+void profile_end(int *phase)
+{
+    depth--;
+    if (depth < PROFILE_MAX_DEPTH)
+        phases[*phase].nanoseconds += now() - startTimes[depth];
+}
+
+void profile_count(int counter, unsigned long amount)
+{
+    int i;
+
+    for (i = 0; i < depth && i < PROFILE_MAX_DEPTH; i++)
+        phases[activePhases[i]].counters[counter] += amount;
+}
+
+void profile_report(FILE *out)
+{
+    int i;
+
+    fprintf(out, "%-26s %12s %12s %10s %12s %12s %14s\n", "phase", "calls", "total ms", "ns/call", "locks", "mallocs", "memcpy bytes");
+    for (i = 0; i < PROFILE_PHASES; i++)
+    {
+        if (phases[i].calls == 0)
+            continue;
+        fprintf(out, "%-26s %12lu %12.3f %10.1f %12lu %12lu %14lu\n", phaseNames[i], phases[i].calls,
+                phases[i].nanoseconds / 1e6, (double)phases[i].nanoseconds / phases[i].calls,
+                phases[i].counters[PROFILE_LOCKS], phases[i].counters[PROFILE_MALLOCS], phases[i].counters[PROFILE_COPY_BYTES]);
+    }
+}
+
+#endif
@@ -0,0 +1,77 @@
+#if !defined(PROFILE_TYPE_DEFINED)
+#define PROFILE_TYPE_DEFINED
+
+/* Hot-path phase profiler.  Compiled in only when PROFILING is defined
+   (e.g. -DPROFILING), otherwise every macro below expands to nothing
+   and costs nothing.
+
+   PROFILE_SCOPE(phase) at the top of a function times the rest of the
+   function, whichever way it returns.  Phases nest: time and the
+   counters (lock acquisitions, mallocs and memcpy'd bytes inside
+   prioque) are charged to every phase active on the calling thread,
+   so the figures of a phase include the phases it calls.
+*/
+
+// main loop phases
+#define PHASE_LOAD 0
+#define PHASE_ARRIVALS 1
+#define PHASE_EXECUTE 2
+#define PHASE_IO 3
+// prioque entry points
+#define PHASE_ADD_TO_QUEUE 4
+#define PHASE_ADD_BATCH_TO_QUEUE 5
+#define PHASE_REMOVE_FROM_FRONT 6
+#define PHASE_REMOVE_N_FROM_FRONT 7
+#define PHASE_PEEK_FRONT 8
+#define PHASE_EMPTY_QUEUE 9
+#define PHASE_QUEUE_LENGTH 10
+#define PHASE_ELEMENT_IN_QUEUE 11
+#define PHASE_COPY_QUEUE 12
+#define PHASE_MERGE_QUEUES 13
+#define PHASE_SPLICE_QUEUES 14
+#define PHASE_DESTROY_QUEUE 15
+#define PROFILE_PHASES 16
+
+#define PROFILE_LOCKS 0
+#define PROFILE_MALLOCS 1
+#define PROFILE_COPY_BYTES 2
+#define PROFILE_COUNTERS 3
+
+#if defined(PROFILING)
+
+#include <stdio.h>
+
+#define PROFILE_SCOPE(phase) \
+    int profile_scope_##phase __attribute__((cleanup(profile_end))) = profile_begin(phase)
+#define PROFILE_COUNT_LOCK() profile_count(PROFILE_LOCKS, 1)
+#define PROFILE_COUNT_MALLOC() profile_count(PROFILE_MALLOCS, 1)
+#define PROFILE_COUNT_COPY(bytes) profile_count(PROFILE_COPY_BYTES, (bytes))
+#define PROFILE_REPORT(out) profile_report(out)
+
+/* starts timing 'phase' on the calling thread, returns 'phase'
+*/
+int profile_begin(int phase);
+
+/* stops timing the phase '*phase', which must be the innermost active one
+*/
+void profile_end(int *phase);
+
+/* adds 'amount' to 'counter' of every active phase of the calling thread
+*/
+void profile_count(int counter, unsigned long amount);
+
+/* writes the summary table of the calling thread to 'out'
+*/
+void profile_report(FILE *out);
+
+#else
+
+#define PROFILE_SCOPE(phase)
+#define PROFILE_COUNT_LOCK()
+#define PROFILE_COUNT_MALLOC()
+#define PROFILE_COUNT_COPY(bytes)
+#define PROFILE_REPORT(out)
+
+#endif
+
+#endif
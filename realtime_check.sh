@@ -0,0 +1,45 @@
+#!/bin/sh
+# realtime_check.sh: checks the admission control of the real-time
+# class on small traces with known outcomes.
+#
+#   usage: ./realtime_check.sh [path/to/mlfqs]
+#
+# Each case runs a trace and compares the "Real-time class:" and
+# "Deadlines:" lines of the report with the expected ones:
+#   o a process whose CPU burst is longer than its deadline is rejected
+#   o processes with deadlines shorter than their periods are admitted
+#     by density, C/min(D, P): two of density 0.8 do not both fit
+#   o admitted sets, with and without MLFQ load, miss no deadline
+
+MLFQS=${1:-./mlfqs}
+status=0
+
+# run_case name expected_admitted expected_rejected expected_bursts expected_missed trace
+run_case()
+{
+    result=$(printf "$6" | "$MLFQS" | awk '
+        /^Real-time class:/ { admitted = $3; rejected = $6 }
+        /^Deadlines:/ { bursts = $2; missed = $5 }
+        END { print admitted + 0, rejected + 0, bursts + 0, missed + 0 }')
+    if [ "$result" != "$2 $3 $4 $5" ]; then
+        echo "realtime_check: $1: got admitted/rejected/bursts/missed $result, expected $2 $3 $4 $5" >&2
+        status=1
+    fi
+}
+
+if [ ! -x "$MLFQS" ]; then
+    echo "realtime_check: $MLFQS is not an executable" >&2
+    exit 2
+fi
+
+run_case "burst longer than its deadline" 0 1 0 0 \
+    "0 1 10 90 5 deadline=5 period=100\n"
+run_case "density above 1 with deadlines shorter than periods" 1 1 6 0 \
+    "0 1 8 92 5 deadline=10 period=100\n0 2 8 92 5 deadline=10 period=100\n"
+run_case "density exactly 1" 2 0 10 0 \
+    "0 1 5 5 4 deadline=10\n0 2 5 5 4 deadline=10\n"
+run_case "admitted set above MLFQ load" 2 0 12 0 \
+    "0 1 4 96 5 deadline=10 period=100\n0 2 4 96 5 deadline=10 period=100\n0 3 50 10 3\n"
+
+[ $status -eq 0 ] && echo "realtime_check: OK"
+exit $status
@@ -0,0 +1,264 @@
+/* recorder: records the CPU and I/O burst behavior of running Linux
+   processes as a trace for the scheduler.
+
+   usage: recorder [-i interval_ms] [-d seconds] [-q ticks] [-b busy_percent] pid... > trace
+
+   Every interval (one tick of the trace, 10 ms by default) the
+   recorder reads /proc/<pid>/schedstat, the time the process ran and
+   waited for a CPU.  A process that wanted a CPU for at least
+   busy_percent (50) of the interval was in a CPU burst, otherwise it
+   was blocked, which the scheduler models as I/O.  Each CPU burst and
+   the blocked time after it form one behavior; identical consecutive
+   behaviors become one line with a repeat count, -q rounds bursts to
+   multiples of 'ticks' so more of them repeat.
+
+   A process arrives at the first tick it was busy.  Blocked time
+   after its last CPU burst is dropped, the process then ends with
+   that burst.  Recording stops after -d seconds, on SIGINT, or once
+   every process exited; the trace is written at that point.  A
+   summary per process, with the bytes it read and wrote according to
+   /proc/<pid>/io, goes to stderr.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "behavior.h"
+
+// Recorded behavior of one process
+typedef struct Recording
+{
+    unsigned int PID;
+    int alive;                      // still running at the last sample
+    int seen;                       // schedstat was read at least once
+    unsigned long long lastDemand;  // ns run plus ns waited for a CPU at the last sample
+    unsigned long arrival;          // tick of the first busy sample
+    unsigned long CPUTicks;         // current CPU burst
+    unsigned long IOTicks;          // blocked ticks after it
+    ProcessBehavior *behaviors;     // behaviors recorded so far, run-length encoded
+    unsigned long count;
+    unsigned long capacity;
+    unsigned long long readBytes[2], writeBytes[2]; // /proc/<pid>/io at the first and last sample
+} Recording;
+
+static volatile sig_atomic_t stopRecording = 0;
+
+static void request_stop(int sig)
+{
+    (void)sig; // SIGINT and SIGTERM are handled alike
+    stopRecording = 1;
+}
+
+// Returns the CPU demand of 'pid' so far in ns (time run plus time runnable), 0 if it is gone
+static int read_demand(unsigned int pid, unsigned long long *demand)
+{
+    char path[64];
+    unsigned long long run, wait;
+    FILE *f;
+    int n;
+
+    snprintf(path, sizeof(path), "/proc/%u/schedstat", pid);
+    f = fopen(path, "r");
+    if (f == NULL)
+        return 0;
+    n = fscanf(f, "%llu %llu", &run, &wait);
+    fclose(f);
+    if (n != 2)
+        return 0;
+    *demand = run + wait;
+    return 1;
+}
+
+// Reads the bytes 'pid' read and wrote so far, leaves them unchanged if /proc/<pid>/io is not readable
+static void read_io(unsigned int pid, unsigned long long *readBytes, unsigned long long *writeBytes)
+{
+    char path[64], key[32];
+    unsigned long long value;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "/proc/%u/io", pid);
+    f = fopen(path, "r");
+    if (f == NULL)
+        return;
+    while (fscanf(f, "%31s %llu", key, &value) == 2)
+    {
+        if (strcmp(key, "read_bytes:") == 0)
+            *readBytes = value;
+        else if (strcmp(key, "write_bytes:") == 0)
+            *writeBytes = value;
+    }
+    fclose(f);
+}
+
+static unsigned long quantize(unsigned long ticks, unsigned long q)
+{
+    if (q <= 1 || ticks == 0)
+        return ticks;
+    ticks = (ticks + q / 2) / q * q;
+    return ticks ? ticks : q;
+}
+
+// Appends a behavior, or repeats the last one if it is identical
+static void append_behavior(Recording *r, unsigned long CPUTicks, unsigned long IOTicks)
+{
+    ProcessBehavior *last = r->count ? &(r->behaviors[r->count - 1]) : NULL;
+
+    if (last != NULL && last->CPUBurst == CPUTicks && last->IOBurst == IOTicks && IOTicks > 0)
+    {
+        last->repeat++;
+        return;
+    }
+    if (r->count == r->capacity)
+    {
+        r->capacity = r->capacity ? 2 * r->capacity : 16;
+        r->behaviors = realloc(r->behaviors, r->capacity * sizeof(ProcessBehavior));
+        if (r->behaviors == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function append_behavior()\n");
+            exit(1);
+        }
+    }
+    r->behaviors[r->count].CPUBurst = CPUTicks;
+    r->behaviors[r->count].IOBurst = IOTicks;
+    r->behaviors[r->count].repeat = 1;
+    r->count++;
+}
+
+// Accounts one tick of 'r', busy or blocked
+static void record_tick(Recording *r, unsigned long tick, int busy, unsigned long q)
+{
+    if (busy)
+    {
+        if (r->IOTicks > 0)
+        {
+            append_behavior(r, quantize(r->CPUTicks, q), quantize(r->IOTicks, q));
+            r->CPUTicks = 0;
+            r->IOTicks = 0;
+        }
+        if (r->CPUTicks == 0 && r->count == 0)
+            r->arrival = tick;
+        r->CPUTicks++;
+    }
+    else if (r->CPUTicks > 0)
+        r->IOTicks++; // blocked before the first CPU burst only delays the arrival
+}
+
+// Ends the recording of 'r' with its last CPU burst
+static void finish_recording(Recording *r, unsigned long q)
+{
+    if (r->CPUTicks > 0)
+        append_behavior(r, quantize(r->CPUTicks, q), 0);
+    r->CPUTicks = 0;
+    r->IOTicks = 0;
+    r->alive = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    Recording *recordings;
+    struct timespec next;
+    unsigned long long demand, interval;
+    unsigned long milliseconds = 10, q = 1, tick, ticks = 0, i, j;
+    double seconds = 0;
+    int busyPercent = 50, opt, count, alive;
+
+    while ((opt = getopt(argc, argv, "i:d:q:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            milliseconds = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            seconds = atof(optarg);
+            break;
+        case 'q':
+            q = strtoul(optarg, NULL, 10);
+            break;
+        case 'b':
+            busyPercent = atoi(optarg);
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    count = argc - optind;
+    if (count <= 0 || milliseconds == 0 || busyPercent <= 0 || busyPercent > 100)
+    {
+        fprintf(stderr, "usage: %s [-i interval_ms] [-d seconds] [-q ticks] [-b busy_percent] pid... > trace\n", argv[0]);
+        return 1;
+    }
+    interval = milliseconds * 1000000ULL;
+    if (seconds > 0)
+        ticks = seconds * 1000 / milliseconds;
+
+    recordings = calloc(count, sizeof(Recording));
+    if (recordings == NULL)
+    {
+        fprintf(stderr, "calloc() failed in function main()\n");
+        return 1;
+    }
+    for (i = 0; i < (unsigned long)count; i++)
+    {
+        recordings[i].PID = strtoul(argv[optind + i], NULL, 10);
+        recordings[i].alive = read_demand(recordings[i].PID, &(recordings[i].lastDemand));
+        recordings[i].seen = recordings[i].alive;
+        if (!recordings[i].alive)
+            fprintf(stderr, "%s: no process %s\n", argv[0], argv[optind + i]);
+        read_io(recordings[i].PID, &(recordings[i].readBytes[0]), &(recordings[i].writeBytes[0]));
+        recordings[i].readBytes[1] = recordings[i].readBytes[0];
+        recordings[i].writeBytes[1] = recordings[i].writeBytes[0];
+    }
+
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (tick = 0, alive = 1; alive && !stopRecording && (ticks == 0 || tick < ticks); tick++)
+    {
+        // absolute wakeups, so the ticks do not drift by the sampling time
+        next.tv_nsec += interval % 1000000000ULL;
+        next.tv_sec += interval / 1000000000ULL + next.tv_nsec / 1000000000L;
+        next.tv_nsec %= 1000000000L;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0 && !stopRecording)
+            ;
+
+        alive = 0;
+        for (i = 0; i < (unsigned long)count; i++)
+        {
+            Recording *r = &recordings[i];
+
+            if (!r->alive)
+                continue;
+            if (!read_demand(r->PID, &demand))
+            {
+                finish_recording(r, q);
+                continue;
+            }
+            read_io(r->PID, &(r->readBytes[1]), &(r->writeBytes[1]));
+            record_tick(r, tick, (demand - r->lastDemand) * 100 >= interval * busyPercent, q);
+            r->lastDemand = demand;
+            alive = 1;
+        }
+    }
+
+    for (i = 0; i < (unsigned long)count; i++)
+    {
+        Recording *r = &recordings[i];
+
+        if (r->alive)
+            finish_recording(r, q);
+        for (j = 0; j < r->count; j++)
+            printf("%lu\t\t%u\t\t%lu\t\t%lu\t\t%u\n", r->arrival, r->PID, r->behaviors[j].CPUBurst, r->behaviors[j].IOBurst,
+                   r->behaviors[j].repeat);
+        if (r->seen)
+            fprintf(stderr, "process %u: arrives at tick %lu, %lu behaviors, read %llu bytes, wrote %llu bytes%s\n", r->PID,
+                    r->arrival, r->count, r->readBytes[1] - r->readBytes[0], r->writeBytes[1] - r->writeBytes[0],
+                    r->count ? "" : " (never busy, left out of the trace)");
+        free(r->behaviors);
+    }
+    free(recordings);
+    return 0;
+}
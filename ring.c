@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "ring.h"
+
+void init_ring(Ring *r, unsigned int elementsize, unsigned long capacity)
+{
+    unsigned long size = 1;
+
+    while (size < capacity)
+        size *= 2;
+
+    r->slots = malloc(size * elementsize);
+    if (r->slots == NULL)
+    {
+        fprintf(stderr, "malloc() failed in function init_ring()\n");
+        exit(1);
+    }
+    r->mask = size - 1;
+    r->elementsize = elementsize;
+    r->head = 0;
+    r->tail = 0;
+    r->closed = 0;
+}
+
+void destroy_ring(Ring *r)
+{
+    free(r->slots);
+    r->slots = NULL;
+}
+
+void ring_put(Ring *r, const void *element)
+{
+    // only the producer writes tail, so it can be read without ordering
+    unsigned long tail = r->tail;
+
+    while (tail - __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE) > r->mask)
+        sched_yield();
+
+    memcpy(r->slots + (tail & r->mask) * r->elementsize, element, r->elementsize);
+    __atomic_store_n(&(r->tail), tail + 1, __ATOMIC_RELEASE);
+}
+
+void close_ring(Ring *r)
+{
+    __atomic_store_n(&(r->closed), 1, __ATOMIC_RELEASE);
+}
+
+const void *ring_peek(Ring *r)
+{
+    unsigned long head = r->head;
+
+    while (__atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE) == head)
+    {
+        // the last put happens before closing, so check the tail again after seeing closed
+        if (__atomic_load_n(&(r->closed), __ATOMIC_ACQUIRE) &&
+            __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE) == head)
+            return NULL;
+        sched_yield();
+    }
+    return r->slots + (head & r->mask) * r->elementsize;
+}
+
+void ring_advance(Ring *r)
+{
+    __atomic_store_n(&(r->head), r->head + 1, __ATOMIC_RELEASE);
+}
+
+int ring_get(Ring *r, void *element)
+{
+    const void *slot = ring_peek(r);
+
+    if (slot == NULL)
+        return 0;
+    memcpy(element, slot, r->elementsize);
+    ring_advance(r);
+    return 1;
+}
@@ -0,0 +1,54 @@
+#if !defined(RING_TYPE_DEFINED)
+#define RING_TYPE_DEFINED
+
+#define RING_CACHE_LINE 64
+
+/* Bounded single-producer, single-consumer ring of fixed size elements.
+   Exactly one thread may put elements and exactly one other thread may
+   get them; no locks are taken.  A full ring blocks the producer and an
+   empty ring the consumer (by yielding the CPU) until the other side
+   catches up or the ring is closed.
+*/
+typedef struct Ring
+{
+    char *slots;               // capacity * elementsize bytes
+    unsigned long mask;        // capacity - 1, capacity is a power of 2
+    unsigned int elementsize;  // 'sizeof()' one element
+    unsigned long head __attribute__((aligned(RING_CACHE_LINE))); // next slot to get, written by the consumer
+    unsigned long tail __attribute__((aligned(RING_CACHE_LINE))); // next slot to put, written by the producer
+    int closed;                // set by the producer after its last put
+} Ring;
+
+/* initializes ring 'r' with room for 'capacity' elements of size
+   'elementsize'; 'capacity' is rounded up to a power of 2
+*/
+void init_ring(Ring *r, unsigned int elementsize, unsigned long capacity);
+
+/* frees the slots of ring 'r'
+*/
+void destroy_ring(Ring *r);
+
+/* producer: copies 'element' into the ring, waiting while it is full
+*/
+void ring_put(Ring *r, const void *element);
+
+/* producer: no more elements will be put
+*/
+void close_ring(Ring *r);
+
+/* consumer: returns a pointer to the oldest element without removing
+   it, waiting while the ring is empty.  Returns NULL once the ring is
+   closed and empty.  The pointer is valid until ring_advance().
+*/
+const void *ring_peek(Ring *r);
+
+/* consumer: removes the element returned by ring_peek()
+*/
+void ring_advance(Ring *r);
+
+/* consumer: removes the oldest element and copies it into 'element'.
+   Returns 0 once the ring is closed and empty, 1 otherwise.
+*/
+int ring_get(Ring *r, void *element);
+
+#endif
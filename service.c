@@ -0,0 +1,404 @@
+#define _GNU_SOURCE // accept4()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "service.h"
+#include "pidset.h"
+
+// A connected client
+typedef struct ServiceClient
+{
+    int fd;
+    char in[SERVICE_LINE_MAX];  // bytes of the command line being received
+    size_t inLength;
+    char *out;                  // replies and events not sent yet
+    size_t outLength;
+    size_t outCapacity;
+    int submitting;             // between SUBMIT and END
+    IngestTable submission;     // processes of the open submission
+    int subscribed;             // receives event lines
+    int filtered;               // only those of process 'PID'
+    unsigned int PID;
+    int closing;                // closed at the end of the poll
+} ServiceClient;
+
+static int listenFd = -1;
+static char *socketPath = NULL;
+static ServiceClient *clients = NULL;
+static unsigned long clientCount = 0, clientCapacity = 0;
+static struct pollfd *pollFds = NULL;
+static unsigned long subscribers = 0;
+static volatile sig_atomic_t shutdownRequested = 0;
+static PIDSet livePIDs; // PIDs of the processes admitted and not finished yet
+
+static void request_shutdown(int sig)
+{
+    (void)sig; // SIGINT and SIGTERM are handled alike
+    shutdownRequested = 1;
+}
+
+int open_service(const char *path)
+{
+    struct sockaddr_un address;
+    struct sigaction action;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+        return -1;
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listenFd, 64) != 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+        return -1;
+    }
+    socketPath = strdup(path);
+    init_pid_set(&livePIDs);
+
+    // no SA_RESTART, so a signal also ends a waiting poll()
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_shutdown;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    return 0;
+}
+
+// Appends 'length' bytes to the output of 'c'; a subscriber too far behind is dropped
+static void send_to_client(ServiceClient *c, const char *text, size_t length)
+{
+    if (c->closing)
+        return;
+    if (c->outLength + length > SERVICE_BACKLOG)
+    {
+        c->closing = 1;
+        return;
+    }
+    if (c->outLength + length > c->outCapacity)
+    {
+        c->outCapacity = c->outCapacity ? 2 * c->outCapacity : 4096;
+        while (c->outCapacity < c->outLength + length)
+            c->outCapacity *= 2;
+        c->out = realloc(c->out, c->outCapacity);
+        if (c->out == NULL)
+        {
+            fprintf(stderr, "realloc() failed in function send_to_client()\n");
+            exit(1);
+        }
+    }
+    memcpy(c->out + c->outLength, text, length);
+    c->outLength += length;
+}
+
+static void reply(ServiceClient *c, const char *text)
+{
+    send_to_client(c, text, strlen(text));
+}
+
+// Sends as much of the output of 'c' as the socket takes without blocking
+static void flush_client(ServiceClient *c)
+{
+    ssize_t sent;
+
+    while (c->outLength > 0)
+    {
+        sent = send(c->fd, c->out, c->outLength, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                c->closing = 1;
+            return;
+        }
+        memmove(c->out, c->out + sent, c->outLength - sent);
+        c->outLength -= sent;
+    }
+}
+
+static void close_client(unsigned long i)
+{
+    ServiceClient *c = &clients[i];
+
+    if (c->subscribed)
+        subscribers--;
+    close(c->fd);
+    free(c->out);
+    destroy_ingest_table(&(c->submission));
+    clients[i] = clients[--clientCount];
+}
+
+/* Moves the processes of the submission of 'c' into 'admitted'.  The
+   whole submission is rejected if one of its PIDs belongs to a process
+   admitted before, by this client or another, that has not finished.
+*/
+static void end_submission(ServiceClient *c, IngestTable *admitted)
+{
+    IngestedProcess *p, *q = NULL;
+    unsigned long i, j;
+    char text[96];
+
+    for (i = 0; i < c->submission.count; i++)
+    {
+        if (pid_in_set(&livePIDs, c->submission.processes[i].PID))
+        {
+            snprintf(text, sizeof(text), "ERROR PID %u is in use, submission discarded\n", c->submission.processes[i].PID);
+            reply(c, text);
+            destroy_ingest_table(&(c->submission));
+            c->submitting = 0;
+            return;
+        }
+    }
+
+    for (i = 0; i < c->submission.count; i++)
+    {
+        p = &(c->submission.processes[i]);
+        add_to_pid_set(&livePIDs, p->PID);
+        for (j = 0; j < p->count; j++)
+            q = ingest_behavior(admitted, p->PID, p->arrival_time, &(ingested_behaviors(p)[j]));
+        if (p->deadline > 0)
+            q->deadline = p->deadline;
+        if (p->period > 0)
+            q->period = p->period;
+        if (p->workingSet > 0)
+            q->workingSet = p->workingSet;
+    }
+    snprintf(text, sizeof(text), "OK %lu processes submitted\n", c->submission.count);
+    reply(c, text);
+    destroy_ingest_table(&(c->submission));
+    c->submitting = 0;
+}
+
+static void handle_line(ServiceClient *c, char *line, IngestTable *admitted)
+{
+    TraceRecord r;
+
+    if (c->submitting)
+    {
+        if (strcmp(line, "END") == 0)
+            end_submission(c, admitted);
+        else if (line[strspn(line, " \t")] == '\0')
+            return; // blank line
+        else if (parse_trace_line(line, &r))
+            ingest_record(&(c->submission), &r);
+        else
+        {
+            reply(c, "ERROR expected a trace line or END, submission discarded\n");
+            destroy_ingest_table(&(c->submission));
+            c->submitting = 0;
+        }
+    }
+    else if (strcmp(line, "SUBMIT") == 0)
+    {
+        if (shutdownRequested)
+            reply(c, "ERROR shutting down\n");
+        else
+        {
+            init_ingest_table(&(c->submission));
+            c->submitting = 1;
+        }
+    }
+    else if (strncmp(line, "SUBSCRIBE", 9) == 0 && (line[9] == '\0' || line[9] == ' '))
+    {
+        if (!c->subscribed)
+            subscribers++;
+        c->subscribed = 1;
+        c->filtered = sscanf(line + 9, "%u", &(c->PID)) == 1;
+        reply(c, "OK subscribed\n");
+    }
+    else if (strcmp(line, "SHUTDOWN") == 0)
+    {
+        shutdownRequested = 1;
+        reply(c, "OK shutting down\n");
+    }
+    else if (strcmp(line, "QUIT") == 0)
+    {
+        reply(c, "OK bye\n");
+        flush_client(c);
+        c->closing = 1;
+    }
+    else if (line[0] != '\0')
+        reply(c, "ERROR unknown command\n");
+}
+
+// Handles the 'length' bytes client 'c' sent in 'buffer', line by line
+static void handle_input(ServiceClient *c, const char *buffer, ssize_t length, IngestTable *admitted)
+{
+    ssize_t i;
+
+    for (i = 0; i < length && !c->closing; i++)
+    {
+        if (buffer[i] == '\n')
+        {
+            if (c->inLength > 0 && c->in[c->inLength - 1] == '\r')
+                c->inLength--;
+            c->in[c->inLength] = '\0';
+            handle_line(c, c->in, admitted);
+            c->inLength = 0;
+        }
+        else if (c->inLength + 1 < SERVICE_LINE_MAX)
+            c->in[c->inLength++] = buffer[i];
+        else
+        {
+            reply(c, "ERROR line too long\n");
+            flush_client(c);
+            c->closing = 1;
+        }
+    }
+}
+
+// Reads everything client 'c' sent so far and handles every complete line
+static void read_client(ServiceClient *c, IngestTable *admitted)
+{
+    char buffer[4096];
+    ssize_t received;
+
+    while (!c->closing)
+    {
+        received = recv(c->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (received <= 0)
+        {
+            c->closing = 1;
+            return;
+        }
+        handle_input(c, buffer, received, admitted);
+    }
+}
+
+static void accept_clients(void)
+{
+    ServiceClient *c;
+    int fd;
+
+    while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        if (clientCount == clientCapacity)
+        {
+            clientCapacity = clientCapacity ? 2 * clientCapacity : 16;
+            clients = realloc(clients, clientCapacity * sizeof(ServiceClient));
+            pollFds = realloc(pollFds, (clientCapacity + 1) * sizeof(struct pollfd));
+            if (clients == NULL || pollFds == NULL)
+            {
+                fprintf(stderr, "realloc() failed in function accept_clients()\n");
+                exit(1);
+            }
+        }
+        c = &clients[clientCount++];
+        memset(c, 0, sizeof(ServiceClient));
+        c->fd = fd;
+    }
+}
+
+void poll_service(IngestTable *admitted, int timeout)
+{
+    unsigned long i, polled;
+
+    for (i = 0; i < clientCount; i++)
+        flush_client(&clients[i]);
+
+    if (pollFds == NULL)
+    {
+        pollFds = malloc(sizeof(struct pollfd));
+        if (pollFds == NULL)
+        {
+            fprintf(stderr, "malloc() failed in function poll_service()\n");
+            exit(1);
+        }
+    }
+    pollFds[0].fd = listenFd;
+    pollFds[0].events = POLLIN;
+    for (i = 0; i < clientCount; i++)
+    {
+        pollFds[i + 1].fd = clients[i].fd;
+        pollFds[i + 1].events = POLLIN | (clients[i].outLength > 0 ? POLLOUT : 0);
+    }
+    polled = clientCount;
+    if (poll(pollFds, polled + 1, shutdownRequested ? 0 : timeout) <= 0)
+        return;
+
+    // clients accepted now are appended, so the polled ones keep their index
+    for (i = 0; i < polled; i++)
+    {
+        if (pollFds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))
+            read_client(&clients[i], admitted);
+        if (pollFds[i + 1].revents & POLLOUT)
+            flush_client(&clients[i]);
+    }
+    if (pollFds[0].revents & POLLIN)
+        accept_clients();
+
+    for (i = clientCount; i-- > 0;)
+    {
+        flush_client(&clients[i]);
+        if (clients[i].closing)
+            close_client(i);
+    }
+}
+
+void service_event(const SchedulerEvent *e)
+{
+    char line[EVENT_LINE_MAX];
+    int length = 0;
+    unsigned long i;
+
+    if (e->type == EVENT_FINISHED)
+        remove_from_pid_set(&livePIDs, e->PID);
+    if (subscribers == 0)
+        return;
+    for (i = 0; i < clientCount; i++)
+    {
+        if (!clients[i].subscribed || (clients[i].filtered && clients[i].PID != e->PID))
+            continue;
+        if (length == 0)
+            length = snprint_event(line, sizeof(line), e);
+        if (length <= 0)
+            return; // no report line
+        send_to_client(&clients[i], line, length);
+    }
+}
+
+int service_shutdown_requested(void)
+{
+    return shutdownRequested;
+}
+
+void close_service(void)
+{
+    while (clientCount > 0)
+    {
+        flush_client(&clients[clientCount - 1]);
+        close_client(clientCount - 1);
+    }
+    free(clients);
+    free(pollFds);
+    clients = NULL;
+    pollFds = NULL;
+    clientCapacity = 0;
+
+    if (listenFd >= 0)
+        close(listenFd);
+    listenFd = -1;
+    if (socketPath != NULL)
+        unlink(socketPath);
+    free(socketPath);
+    socketPath = NULL;
+    destroy_pid_set(&livePIDs);
+}
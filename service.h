@@ -0,0 +1,59 @@
+#if !defined(SERVICE_TYPE_DEFINED)
+#define SERVICE_TYPE_DEFINED
+
+#include "event.h"
+#include "ingest.h"
+
+#define SERVICE_LINE_MAX 256        // longest command line a client may send
+#define SERVICE_BACKLOG (1UL << 20) // bytes of events a subscriber may lag behind before it is dropped
+
+/* Scheduler service on a Unix domain socket.  Clients connect and send
+   text commands, one per line, and get replies starting with OK or
+   ERROR:
+
+     SUBMIT             starts a submission; the lines that follow are
+     <trace lines>      trace lines (arrival PID CPUBurst IOBurst repeat
+                        [deadline=D] [period=P] [wss=W]),
+     END                and END hands the whole submission to the
+                        scheduler, which admits it at its next tick
+     SUBSCRIBE [PID]    streams the report lines of every event, or only
+                        of process PID, to the client
+     SHUTDOWN           stops accepting work; the scheduler finishes the
+                        processes it has and exits
+     QUIT               closes the connection
+
+   PIDs must be unique among the processes the scheduler holds: a
+   submission with the PID of a process admitted before, by any client,
+   that has not finished yet is rejected with ERROR as a whole.  The
+   service runs on the scheduler thread: commands are handled whenever
+   the scheduler polls, reading everything the clients sent so far, and
+   a subscriber that falls SERVICE_BACKLOG bytes behind is disconnected
+   instead of stalling the scheduler.
+*/
+
+/* creates the listening socket 'path', replacing a stale socket file.
+   SIGINT and SIGTERM then request a shutdown.  Returns 0 on success,
+   -1 with errno set otherwise.
+*/
+int open_service(const char *path);
+
+/* handles new connections and pending commands, waiting up to
+   'timeout' milliseconds (-1 waits until something happens) for them.
+   Processes of completed submissions are added to 'admitted'.
+*/
+void poll_service(IngestTable *admitted, int timeout);
+
+/* queues the report line of event 'e' for the subscribers of its process
+*/
+void service_event(const SchedulerEvent *e);
+
+/* returns nonzero once SHUTDOWN was received or a signal asked to stop
+*/
+int service_shutdown_requested(void);
+
+/* sends what is queued for the clients as far as they take it without
+   blocking, closes every connection and removes the socket file
+*/
+void close_service(void);
+
+#endif